@@ -0,0 +1,920 @@
+#include "BiquadCascade.h"
+#include "PluginProcessor.h"
+
+static_assert(ChainCoefficients::MaxCutSections == Slope::Slope_48 + 1,
+              "A cut stage runs one section per 12 dB/Oct of slope");
+
+// Enough for the widest variant's vectors
+static constexpr size_t vectorAlignment = 64;
+
+using SVFParameters = std::array<double, SIMDKernels::NumSVFParameters>;
+
+// The TPT state variable filter with the same response as a biquad. Undoing the
+// bilinear transform gives the analog prototype; its cutoff and damping are g and k.
+static SVFParameters toStateVariable(const BiquadCoefficients& coefficients)
+{
+    const double b0 = coefficients.b0, b1 = coefficients.b1, b2 = coefficients.b2;
+    const double a1 = coefficients.a1, a2 = coefficients.a2;
+
+    const auto d0 = 1 + a1 + a2, d1 = 2 * (1 - a2), d2 = 1 - a1 + a2;
+    const auto n0 = b0 + b1 + b2, n1 = 2 * (b0 - b2), n2 = b0 - b1 + b2;
+
+    // Both ends of the denominator are positive for any stable section
+    jassert(d0 > 0 && d2 > 0);
+    const auto safeD0 = juce::jmax(d0, 1e-30), safeD2 = juce::jmax(d2, 1e-30);
+    const auto root = std::sqrt(safeD0 * safeD2);
+
+    const auto g = std::sqrt(safeD0 / safeD2);
+    const auto k = d1 / root;
+    const auto m0 = n2 / safeD2;
+    const auto m1 = n1 / root - m0 * k;
+    const auto m2 = n0 / safeD0 - m0;
+
+    return { g, k, m0, m1, m2 };
+}
+
+//==============================================================================
+struct HalfBandStage
+{
+    std::array<double, SIMDKernels::MaxHalfBandCoefficients> coefficients {};
+    std::array<float, SIMDKernels::MaxHalfBandCoefficients> floatCoefficients {};
+    int numCoefficients = 0;
+    double groupDelay = 0;  // At the higher rate, towards DC
+
+    template<typename SampleType>
+    const SampleType* getCoefficients() const
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return coefficients.data();
+        else
+            return floatCoefficients.data();
+    }
+};
+
+// Allpass coefficients of an elliptic half-band filter, as in Laurent de Soras'
+// HIIR. transition is the width of the transition band relative to the higher rate.
+static HalfBandStage designHalfBand(int numCoefficients, double transition)
+{
+    constexpr auto pi = juce::MathConstants<double>::pi;
+
+    auto k = std::tan((1 - transition * 2) * pi / 4);
+    k *= k;
+    const auto kRoot = std::pow(1 - k * k, 0.25);
+    const auto e = 0.5 * (1 - kRoot) / (1 + kRoot);
+    const auto e4 = e * e * e * e;
+    const auto q = e * (1 + e4 * (2 + e4 * (15 + 150 * e4)));
+
+    const auto order = numCoefficients * 2 + 1;
+    HalfBandStage stage;
+    stage.numCoefficients = numCoefficients;
+
+    for (int index = 0; index < numCoefficients; ++index)
+    {
+        const auto c = index + 1;
+
+        auto numerator = 0.0;
+        for (int i = 0, sign = 1; i < 100; ++i, sign = -sign)
+        {
+            const auto term = std::pow(q, i * (i + 1)) * std::sin((i * 2 + 1) * c * pi / order) * sign;
+            numerator += term;
+            if (std::abs(term) <= 1e-100)
+                break;
+        }
+
+        auto denominator = 0.5;
+        for (int i = 1, sign = -1; i < 100; ++i, sign = -sign)
+        {
+            const auto term = std::pow(q, i * i) * std::cos(i * 2 * c * pi / order) * sign;
+            denominator += term;
+            if (std::abs(term) <= 1e-100)
+                break;
+        }
+
+        const auto ww = numerator * std::pow(q, 0.25) / denominator;
+        const auto wwSquared = ww * ww;
+        const auto x = std::sqrt((1 - wwSquared * k) * (1 - wwSquared / k)) / (1 + wwSquared);
+
+        stage.coefficients[(size_t) index] = (1 - x) / (1 + x);
+        stage.floatCoefficients[(size_t) index] = (float) stage.coefficients[(size_t) index];
+    }
+
+    // H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2; its phase slope near DC is the delay
+    auto response = [&stage](double frequency)
+    {
+        const auto zInverse = std::polar(1.0, -2 * pi * frequency);
+        const auto zInverse2 = zInverse * zInverse;
+        std::complex<double> chains[2] = { 1.0, 1.0 };
+
+        for (int i = 0; i < stage.numCoefficients; ++i)
+        {
+            const auto a = stage.coefficients[(size_t) i];
+            chains[i % 2] *= (a + zInverse2) / (1.0 + a * zInverse2);
+        }
+
+        return (chains[0] + zInverse * chains[1]) * 0.5;
+    };
+
+    constexpr auto delta = 1e-5;
+    stage.groupDelay = -(std::arg(response(2 * delta)) - std::arg(response(delta))) / (2 * pi * delta);
+    return stage;
+}
+
+// The first stage does the real work, passing 20 kHz at 44.1 kHz with over
+// 110 dB of rejection. Above that, the audio band is a small part of the
+// spectrum and a short filter does.
+static const std::array<HalfBandStage, 2>& getHalfBandStages()
+{
+    static const std::array<HalfBandStage, 2> stages { designHalfBand(10, 0.03), designHalfBand(6, 0.1) };
+    return stages;
+}
+
+static int getNumOversamplingStages(int factor)
+{
+    return factor >= 4 ? 2 : (factor >= 2 ? 1 : 0);
+}
+
+double BiquadCascadeBase::getOversamplingLatency(int factor)
+{
+    // Up and down at each stage's higher rate; taking the downsampled output on
+    // odd samples saves one sample of that
+    auto latency = 0.0;
+    auto rate = 2.0;
+
+    for (int stage = 0; stage < getNumOversamplingStages(factor); ++stage, rate *= 2)
+        latency += (2 * getHalfBandStages()[(size_t) stage].groupDelay - 1) / rate;
+
+    return latency;
+}
+
+double BiquadCascadeBase::getOversamplingTailLength(int factor, double threshold)
+{
+    // Every allpass section has its poles at radius sqrt(a) per sample of the
+    // higher rate. Summing the sections of both chains, up and down, errs long.
+    auto samples = 0.0;
+    auto rate = 2.0;
+
+    for (int stage = 0; stage < getNumOversamplingStages(factor); ++stage, rate *= 2)
+    {
+        const auto& halfBand = getHalfBandStages()[(size_t) stage];
+
+        for (int i = 0; i < halfBand.numCoefficients; ++i)
+            samples += 2 * std::log(threshold) / std::log(std::sqrt(halfBand.coefficients[(size_t) i])) / rate;
+    }
+
+    return samples;
+}
+
+//==============================================================================
+template<typename SampleType>
+void BiquadCascade<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    const auto channels = juce::jmax(1, (int) spec.numChannels);
+    prepareLayouts(spec, SIMDKernels::getKernelSetForChannels(channels, isDoublePrecision),
+                   SIMDKernels::getKernelSetForChannels(2 * channels, isDoublePrecision));
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::prepare(const juce::dsp::ProcessSpec& spec, const SIMDKernels::KernelSet& kernelsToUse)
+{
+    prepareLayouts(spec, kernelsToUse, kernelsToUse);
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::prepareLayouts(const juce::dsp::ProcessSpec& spec,
+                                               const SIMDKernels::KernelSet& directKernels,
+                                               const SIMDKernels::KernelSet& crossfadeKernels)
+{
+    numChannels = juce::jmax(1, (int) spec.numChannels);
+
+    auto makeLayout = [this](const SIMDKernels::KernelSet& layoutKernels, int numChains)
+    {
+        const auto lanes = layoutKernels.template getCascadeKernels<SampleType>().numLanes;
+        const auto chainLanes = juce::jmax(1, lanes / numChains);
+        return Layout { &layoutKernels, lanes, chainLanes, (numChannels + chainLanes - 1) / chainLanes };
+    };
+
+    directLayout = makeLayout(directKernels, 1);
+    crossfadeLayout = makeLayout(crossfadeKernels, 2);
+
+    // Everything is allocated up front for both layouts, so switching mode never allocates
+    size_t sectionSize = 0, frameSize = 0, halfBandStateSize = 0;
+    int maxGroups = 0;
+
+    for (auto* layout : { &directLayout, &crossfadeLayout })
+    {
+        sectionSize = juce::jmax(sectionSize, (size_t) (layout->numGroups * MaxSections * SIMDKernels::SectionStride * layout->numLanes));
+        frameSize = juce::jmax(frameSize, spec.maximumBlockSize * (size_t) (layout->numLanes * MaxOversamplingFactor));
+        halfBandStateSize = juce::jmax(halfBandStateSize, (size_t) (layout->numGroups * 2 * 2 * SIMDKernels::MaxHalfBandCoefficients
+                                                                    * SIMDKernels::HalfBandStateStride * layout->numLanes));
+        maxGroups = juce::jmax(maxGroups, layout->numGroups);
+    }
+
+    const auto smoothedSize = (size_t) (directLayout.numGroups * MaxSections * SIMDKernels::SVFStride * directLayout.numLanes);
+
+    sections = juce::dsp::AudioBlock<SampleType>(sectionData, 1, sectionSize, vectorAlignment);
+    previousSections = juce::dsp::AudioBlock<SampleType>(previousSectionData, 1, sectionSize, vectorAlignment);
+    smoothedSections = juce::dsp::AudioBlock<SampleType>(smoothedSectionData, 1, smoothedSize, vectorAlignment);
+    previousSmoothedSections = juce::dsp::AudioBlock<SampleType>(previousSmoothedSectionData, 1, smoothedSize, vectorAlignment);
+    frames = juce::dsp::AudioBlock<SampleType>(frameData, (size_t) maxGroups, frameSize, vectorAlignment);
+    halfBandStates = juce::dsp::AudioBlock<SampleType>(halfBandStateData, 1, halfBandStateSize, vectorAlignment);
+    previousHalfBandStates = juce::dsp::AudioBlock<SampleType>(previousHalfBandStateData, 1, halfBandStateSize, vectorAlignment);
+
+    sections.clear();
+    smoothedSections.clear();
+    frames.clear();
+    halfBandStates.clear();
+
+    rampSamplesRemaining = 0;
+    fadeSamplesRemaining = 0;
+    useLayout(directLayout);
+
+    // The layout may have changed, so lay every section out again from its slot
+    numActiveSections = 0;
+    packSections();
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::useLayout(const Layout& layout)
+{
+    kernels = layout.kernels;
+    cascadeKernels = &kernels->template getCascadeKernels<SampleType>();
+    numLanes = layout.numLanes;
+    lanesPerChain = layout.lanesPerChain;
+    numGroups = layout.numGroups;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::moveStateToLayout(const Layout& layout, int fromChain)
+{
+    previousSections.copyFrom(sections);
+    previousHalfBandStates.copyFrom(halfBandStates);
+
+    const auto oldLanes = (size_t) numLanes;
+    const auto oldChainLanes = lanesPerChain;
+    const auto oldGroupSize = getGroupSize();
+
+    useLayout(layout);
+
+    const auto lanes = (size_t) numLanes;
+    const auto groupSize = getGroupSize();
+    constexpr auto halfBandRows = (size_t) (SIMDKernels::MaxHalfBandCoefficients * SIMDKernels::HalfBandStateStride);
+    constexpr auto numHalfBandStates = 2 * 2;   // Stage, then direction
+
+    // Lanes without a channel stay silent
+    halfBandStates.clear();
+
+    for (int group = 0; group < numGroups; ++group)
+        for (int p = 0; p < numActiveSections; ++p)
+            std::fill(getSection(group, p) + SIMDKernels::S1 * numLanes, getSection(group, p) + SIMDKernels::SectionStride * numLanes, 0.f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto oldGroup = (size_t) (channel / oldChainLanes);
+        const auto oldLane = (size_t) (fromChain * oldChainLanes + channel % oldChainLanes);
+        const auto group = (size_t) (channel / lanesPerChain);
+
+        for (int chain = 0; chain < getNumChains(); ++chain)
+        {
+            const auto lane = (size_t) (chain * lanesPerChain + channel % lanesPerChain);
+
+            for (int p = 0; p < numActiveSections; ++p)
+            {
+                const auto* from = previousSections.getChannelPointer(0) + oldGroup * oldGroupSize
+                                 + (size_t) (p * SIMDKernels::SectionStride) * oldLanes;
+                auto* to = sections.getChannelPointer(0) + group * groupSize + (size_t) (p * SIMDKernels::SectionStride) * lanes;
+
+                for (auto row : { SIMDKernels::S1, SIMDKernels::S2 })
+                    to[(size_t) row * lanes + lane] = from[(size_t) row * oldLanes + oldLane];
+            }
+
+            for (size_t state = 0; state < numHalfBandStates; ++state)
+            {
+                const auto* from = previousHalfBandStates.getChannelPointer(0) + (oldGroup * numHalfBandStates + state) * halfBandRows * oldLanes;
+                auto* to = halfBandStates.getChannelPointer(0) + (group * numHalfBandStates + state) * halfBandRows * lanes;
+
+                for (size_t row = 0; row < halfBandRows; ++row)
+                    to[row * lanes + lane] = from[row * oldLanes + oldLane];
+            }
+        }
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::reset()
+{
+    halfBandStates.clear();
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        for (int p = 0; p < numActiveSections; ++p)
+        {
+            auto* section = getSection(group, p);
+            std::fill(section + SIMDKernels::S1 * numLanes, section + SIMDKernels::SectionStride * numLanes, 0.f);
+
+            if (mode == UpdateMode::ramped)
+            {
+                auto* smoothed = getSmoothedSection(group, p);
+                std::fill(smoothed + SIMDKernels::IC1 * numLanes, smoothed + SIMDKernels::SVFStride * numLanes, 0.f);
+            }
+        }
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::setOversamplingFactor(int newFactor)
+{
+    newFactor = newFactor >= 4 ? 4 : (newFactor >= 2 ? 2 : 1);
+
+    if (newFactor == oversamplingFactor)
+        return;
+
+    oversamplingFactor = newFactor;
+    numOversamplingStages = getNumOversamplingStages(newFactor);
+
+    // The state belongs to the old rate, and so do the coefficients until the
+    // next ones arrive, which take over straight away
+    rampSamplesRemaining = 0;
+    finishRamp();
+    reset();
+    skipNextTransition = true;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::setUpdateMode(UpdateMode newMode, int transitionLengthInSamples)
+{
+    transitionLength = (size_t) juce::jmax(0, transitionLengthInSamples);
+
+    if (newMode == mode)
+        return;
+
+    // The filter form changes, so start again from silence
+    mode = newMode;
+    rampSamplesRemaining = 0;
+    fadeSamplesRemaining = 0;
+    useLayout(directLayout);
+
+    numActiveSections = 0;
+    packSections();
+}
+
+template<typename SampleType>
+size_t BiquadCascade<SampleType>::getGroupSize() const
+{
+    // A multiple of every variant's vector size, so each group stays aligned
+    return (size_t) (MaxSections * SIMDKernels::SectionStride * numLanes);
+}
+
+template<typename SampleType>
+SampleType* BiquadCascade<SampleType>::getSection(int group, int packedIndex) const
+{
+    return sections.getChannelPointer(0) + (size_t) group * getGroupSize()
+                                         + (size_t) (packedIndex * SIMDKernels::SectionStride * numLanes);
+}
+
+template<typename SampleType>
+size_t BiquadCascade<SampleType>::getSmoothedGroupSize() const
+{
+    return (size_t) (MaxSections * SIMDKernels::SVFStride * numLanes);
+}
+
+template<typename SampleType>
+SampleType* BiquadCascade<SampleType>::getSmoothedSection(int group, int packedIndex) const
+{
+    return smoothedSections.getChannelPointer(0) + (size_t) group * getSmoothedGroupSize()
+                                                 + (size_t) (packedIndex * SIMDKernels::SVFStride * numLanes);
+}
+
+template<typename SampleType>
+SampleType* BiquadCascade<SampleType>::getHalfBandState(int group, int stage, bool downsampling) const
+{
+    const auto stateSize = (size_t) (SIMDKernels::MaxHalfBandCoefficients * SIMDKernels::HalfBandStateStride * numLanes);
+    return halfBandStates.getChannelPointer(0) + (size_t) ((group * 2 + stage) * 2 + (downsampling ? 1 : 0)) * stateSize;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::setSlot(int channelSet, int slot, const BiquadCoefficients& coefficients, bool active)
+{
+    slots[(size_t) channelSet].coefficients[(size_t) slot] = coefficients;
+    slots[(size_t) channelSet].active[(size_t) slot] = active;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::packSections()
+{
+    // Nothing to lay out until prepare() has allocated the sections
+    if (sections.getNumSamples() == 0)
+        return;
+
+    // Where each slot lived before repacking, so its state can follow it
+    std::array<int, MaxSections> previousIndex;
+    previousIndex.fill(-1);
+    for (int p = 0; p < numActiveSections; ++p)
+        previousIndex[(size_t) packedSlots[(size_t) p]] = p;
+
+    // A slot runs if any channel set needs it, in either chain while crossfading
+    std::array<bool, MaxSections> packedActive {};
+    for (size_t slot = 0; slot < packedActive.size(); ++slot)
+        for (size_t set = 0; set < (size_t) NumChannelSets; ++set)
+            packedActive[slot] = packedActive[slot] || slots[set].active[slot]
+                              || (isCrossfading() && fadeFromSlots[set].active[slot]);
+
+    int packed = 0;
+
+    for (int slot = 0; slot < MaxSections; ++slot)
+        if (packedActive[(size_t) slot])
+            packedSlots[(size_t) packed++] = slot;
+
+    numActiveSections = packed;
+
+    if (mode == UpdateMode::ramped)
+        packSmoothedSections(previousIndex);
+    else
+        packDirectSections(previousIndex);
+
+    // Full passes, then whatever is left
+    numPasses = (numActiveSections + SIMDKernels::MaxSectionsPerPass - 1) / SIMDKernels::MaxSectionsPerPass;
+
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+        const auto numPassSections = (size_t) juce::jmin(SIMDKernels::MaxSectionsPerPass,
+                                                         numActiveSections - pass * SIMDKernels::MaxSectionsPerPass);
+        passKernels[(size_t) pass] = cascadeKernels->cascade[numPassSections];
+        smoothedPassKernels[(size_t) pass] = cascadeKernels->smoothedCascade[numPassSections];
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::packDirectSections(const std::array<int, MaxSections>& previousIndex)
+{
+    // Only the state of sections that keep running is read back, so only
+    // those rows are set aside before the sections are laid out over them
+    for (int p = 0; p < numActiveSections; ++p)
+    {
+        const auto previousPosition = previousIndex[(size_t) packedSlots[(size_t) p]];
+        if (previousPosition < 0)
+            continue;
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            const auto offset = (size_t) group * getGroupSize()
+                              + (size_t) ((previousPosition * SIMDKernels::SectionStride + SIMDKernels::S1) * numLanes);
+            const auto* from = sections.getChannelPointer(0) + offset;
+            std::copy(from, from + (SIMDKernels::SectionStride - SIMDKernels::S1) * numLanes,
+                      previousSections.getChannelPointer(0) + offset);
+        }
+    }
+
+    // Passes the signal through untouched, for a slot only the other chain
+    // or channel set runs
+    const BiquadCoefficients identity;
+
+    for (int p = 0; p < numActiveSections; ++p)
+    {
+        const auto slot = (size_t) packedSlots[(size_t) p];
+        const auto previousPosition = previousIndex[slot];
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            auto* section = getSection(group, p);
+            const auto* previous = previousSections.getChannelPointer(0) + (size_t) group * getGroupSize()
+                                 + (size_t) (juce::jmax(0, previousPosition) * SIMDKernels::SectionStride * numLanes);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                // While crossfading the lower chain is the old one
+                const auto isOldChain = lane < lanesPerChain && isCrossfading();
+                const auto& laneSlots = (isOldChain ? fadeFromSlots : slots)[(size_t) getLaneChannelSet(group, lane % lanesPerChain)];
+                const auto active = laneSlots.active[slot];
+                const auto& coefficients = active ? laneSlots.coefficients[slot] : identity;
+
+                auto setRow = [&](int row, SampleType value) { section[row * numLanes + lane] = value; };
+
+                setRow(SIMDKernels::B0, (SampleType) coefficients.b0);
+                setRow(SIMDKernels::B1, (SampleType) coefficients.b1);
+                setRow(SIMDKernels::B2, (SampleType) coefficients.b2);
+                setRow(SIMDKernels::A1, (SampleType) coefficients.a1);
+                setRow(SIMDKernels::A2, (SampleType) coefficients.a2);
+
+                const auto keepState = previousPosition >= 0 && active;
+
+                for (auto row : { SIMDKernels::S1, SIMDKernels::S2 })
+                    setRow(row, keepState ? previous[row * numLanes + lane] : SampleType(0));
+            }
+        }
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::packSmoothedSections(const std::array<int, MaxSections>& previousIndex)
+{
+    // As in packDirectSections(): the parameters the glide continues from,
+    // and the state, of the sections that keep running
+    for (int p = 0; p < numActiveSections; ++p)
+    {
+        const auto previousPosition = previousIndex[(size_t) packedSlots[(size_t) p]];
+        if (previousPosition < 0)
+            continue;
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            const auto offset = (size_t) group * getSmoothedGroupSize()
+                              + (size_t) (previousPosition * SIMDKernels::SVFStride * numLanes);
+            const auto* from = smoothedSections.getChannelPointer(0) + offset;
+            auto* to = previousSmoothedSections.getChannelPointer(0) + offset;
+
+            std::copy(from + SIMDKernels::G * numLanes, from + SIMDKernels::NumSVFParameters * numLanes,
+                      to + SIMDKernels::G * numLanes);
+            std::copy(from + SIMDKernels::IC1 * numLanes, from + SIMDKernels::SVFStride * numLanes,
+                      to + SIMDKernels::IC1 * numLanes);
+        }
+    }
+
+    // The kernel counts samples at the oversampled rate
+    const auto rampLength = skipNextTransition ? 0 : transitionLength * (size_t) oversamplingFactor;
+    const auto identity = toStateVariable({});
+
+    for (int p = 0; p < numActiveSections; ++p)
+    {
+        const auto slot = (size_t) packedSlots[(size_t) p];
+        const auto previousPosition = previousIndex[slot];
+
+        for (size_t set = 0; set < (size_t) NumChannelSets; ++set)
+            smoothedTargets[set][(size_t) p] = slots[set].active[slot] ? toStateVariable(slots[set].coefficients[slot]) : identity;
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            auto* section = getSmoothedSection(group, p);
+            const auto* previous = previousSmoothedSections.getChannelPointer(0) + (size_t) group * getSmoothedGroupSize()
+                                 + (size_t) (juce::jmax(0, previousPosition) * SIMDKernels::SVFStride * numLanes);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto& target = smoothedTargets[(size_t) getLaneChannelSet(group, lane % lanesPerChain)][(size_t) p];
+
+                // Sections that were already running glide from where they are; new ones start on target
+                for (int r = 0; r < SIMDKernels::NumSVFParameters; ++r)
+                {
+                    const auto current = previousPosition >= 0 && rampLength > 0 ? (double) previous[(SIMDKernels::G + r) * numLanes + lane]
+                                                                                  : target[(size_t) r];
+                    section[(SIMDKernels::G + r) * numLanes + lane] = (SampleType) current;
+                    section[(SIMDKernels::DeltaG + r) * numLanes + lane]
+                        = (SampleType) (rampLength > 0 ? (target[(size_t) r] - current) / (double) rampLength : 0.0);
+                }
+
+                for (auto row : { SIMDKernels::IC1, SIMDKernels::IC2 })
+                    section[row * numLanes + lane] = previousPosition >= 0 ? previous[row * numLanes + lane] : SampleType(0);
+            }
+        }
+    }
+
+    rampSamplesRemaining = rampLength;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::finishRamp()
+{
+    for (int p = 0; p < numActiveSections; ++p)
+    {
+        for (int group = 0; group < numGroups; ++group)
+        {
+            auto* section = getSmoothedSection(group, p);
+
+            // Snap to the exact target so rounding in the ramp doesn't build up
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto& target = smoothedTargets[(size_t) getLaneChannelSet(group, lane % lanesPerChain)][(size_t) p];
+
+                for (int r = 0; r < SIMDKernels::NumSVFParameters; ++r)
+                {
+                    section[(SIMDKernels::G + r) * numLanes + lane] = (SampleType) target[(size_t) r];
+                    section[(SIMDKernels::DeltaG + r) * numLanes + lane] = 0;
+                }
+            }
+        }
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::finishCrossfade()
+{
+    // Back to one chain per vector, the new chain's state moving down to take
+    // the old one's place; repacking then drops any section only the old chain
+    // was using
+    moveStateToLayout(directLayout, 1);
+    packSections();
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::advanceTransitions(size_t numSamples)
+{
+    if (rampSamplesRemaining > 0)
+    {
+        rampSamplesRemaining -= juce::jmin(rampSamplesRemaining, numSamples * (size_t) oversamplingFactor);
+
+        if (rampSamplesRemaining == 0)
+            finishRamp();
+    }
+
+    if (fadeSamplesRemaining > 0)
+    {
+        fadeSamplesRemaining -= juce::jmin(fadeSamplesRemaining, numSamples);
+
+        if (fadeSamplesRemaining == 0)
+            finishCrossfade();
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::setCoefficients(const StereoChainCoefficients& coefficients, const std::array<bool, 3>& stagesToApply)
+{
+    // The encoded signal has nothing to do with the state built up before
+    if (const auto newMidSide = coefficients.mode == StereoMode::midSide; newMidSide != midSide)
+    {
+        midSide = newMidSide;
+        reset();
+    }
+
+    // The old chain keeps whatever was running before; a fade already under way keeps its old chain
+    const auto startFade = mode == UpdateMode::crossfade && crossfadeLayout.numLanes / crossfadeLayout.lanesPerChain > 1
+                        && transitionLength > 0 && ! isCrossfading() && ! skipNextTransition;
+
+    // Both chains start out from the state of the one running so far
+    if (startFade)
+    {
+        fadeFromSlots = slots;
+        moveStateToLayout(crossfadeLayout, 0);
+    }
+
+    for (int set = 0; set < NumChannelSets; ++set)
+    {
+        const auto& chain = coefficients.channelSets[(size_t) set];
+
+        if (stagesToApply[ChainPositions::LowCut])
+        {
+            for (int i = 0; i < ChainCoefficients::MaxCutSections; ++i)
+                setSlot(set, i, chain.lowCut[(size_t) i],
+                        ! chain.lowCutBypassed && i < chain.numLowCutSections);
+        }
+
+        if (stagesToApply[ChainPositions::Peak])
+        {
+            for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+                setSlot(set, FirstPeakSection + i, chain.peaks[(size_t) i], chain.peakActive[(size_t) i]);
+        }
+
+        if (stagesToApply[ChainPositions::HighCut])
+        {
+            for (int i = 0; i < ChainCoefficients::MaxCutSections; ++i)
+                setSlot(set, FirstHighCutSection + i, chain.highCut[(size_t) i],
+                        ! chain.highCutBypassed && i < chain.numHighCutSections);
+        }
+    }
+
+    if (startFade)
+        fadeLength = fadeSamplesRemaining = transitionLength;
+
+    packSections();
+    skipNextTransition = false;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::interleave(const juce::dsp::AudioBlock<SampleType>& block, SampleType* frame, bool midSideChannels)
+{
+    const auto lanes = (size_t) numLanes;
+    const auto chainLanes = (size_t) lanesPerChain;
+    const auto numGroupChannels = juce::jmin(block.getNumChannels(), chainLanes);
+    const auto numSamples = block.getNumSamples();
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        // Each chain gets its own copy of the group's channels. Unused lanes
+        // are fed silence so their state stays at zero.
+        const auto ch = lane % chainLanes;
+
+        if (midSideChannels && ch < 2)
+        {
+            // Mid, then side
+            auto* left = block.getChannelPointer(0);
+            auto* right = block.getChannelPointer(1);
+            const auto sign = ch == 0 ? SampleType(1) : SampleType(-1);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                frame[i * lanes + lane] = (left[i] + sign * right[i]) * SampleType(0.5);
+        }
+        else if (ch < numGroupChannels)
+        {
+            auto* src = block.getChannelPointer(ch);
+            for (size_t i = 0; i < numSamples; ++i)
+                frame[i * lanes + lane] = src[i];
+        }
+        else
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+                frame[i * lanes + lane] = 0;
+        }
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::deinterleave(const juce::dsp::AudioBlock<SampleType>& block, const SampleType* frame, bool midSideChannels)
+{
+    const auto lanes = (size_t) numLanes;
+    const auto chainLanes = (size_t) lanesPerChain;
+    const auto numGroupChannels = juce::jmin(block.getNumChannels(), chainLanes);
+    const auto numSamples = block.getNumSamples();
+
+    // Linear, since both chains carry almost the same signal
+    const auto crossfading = isCrossfading();
+    const auto newChainLane = crossfading ? chainLanes : 0;
+    const auto fadeStart = crossfading ? (SampleType) (fadeLength - fadeSamplesRemaining) : SampleType(0);
+    const auto fadeStep = crossfading ? SampleType(1) / (SampleType) fadeLength : SampleType(0);
+
+    auto output = [&](size_t i, size_t ch)
+    {
+        const auto newSample = frame[i * lanes + newChainLane + ch];
+        if (! crossfading)
+            return newSample;
+
+        const auto oldSample = frame[i * lanes + ch];
+        const auto amount = juce::jmin(SampleType(1), (fadeStart + (SampleType) (i + 1)) * fadeStep);
+        return oldSample + (newSample - oldSample) * amount;
+    };
+
+    size_t firstChannel = 0;
+
+    if (midSideChannels)
+    {
+        auto* left = block.getChannelPointer(0);
+        auto* right = block.getChannelPointer(1);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto mid = output(i, 0), side = output(i, 1);
+            left[i] = mid + side;
+            right[i] = mid - side;
+        }
+
+        firstChannel = 2;
+    }
+
+    for (size_t ch = firstChannel; ch < numGroupChannels; ++ch)
+    {
+        auto* dst = block.getChannelPointer(ch);
+        for (size_t i = 0; i < numSamples; ++i)
+            dst[i] = output(i, ch);
+    }
+}
+
+template<typename SampleType>
+int BiquadCascade<SampleType>::getNumLaneGroups(const juce::dsp::AudioBlock<SampleType>& block) const
+{
+    return ((int) block.getNumChannels() + lanesPerChain - 1) / lanesPerChain;
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::processLaneGroup(const juce::dsp::AudioBlock<SampleType>& block, int group)
+{
+    const auto numSamples = block.getNumSamples();
+    jassert(numSamples * (size_t) numLanes <= frames.getNumSamples());
+    jassert(block.getNumChannels() <= getMaxNumChannels());
+    jassert(juce::isPositiveAndBelow(group, numGroups));
+
+    const auto chainLanes = (size_t) lanesPerChain;
+    const auto firstChannel = (size_t) group * chainLanes;
+    auto groupBlock = block.getSubsetChannelBlock(firstChannel, juce::jmin(chainLanes, block.getNumChannels() - firstChannel));
+
+    // Each group has its own frame buffer, so groups can run on different threads
+    auto* frame = frames.getChannelPointer((size_t) group);
+    const auto numOversampledSamples = numSamples * (size_t) oversamplingFactor;
+
+    // The group holding both channels encodes and decodes them itself
+    const auto groupMidSide = midSide && encodesMidSideInGroups() && firstChannel == 0 && groupBlock.getNumChannels() >= 2;
+
+    // Interleaved at the end of the buffer, so each upsampling stage can work in place
+    interleave(groupBlock, frame + (numOversampledSamples - numSamples) * (size_t) numLanes, groupMidSide);
+    upsample(group, frame, numSamples);
+
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+        const auto firstSection = pass * SIMDKernels::MaxSectionsPerPass;
+
+        if (mode == UpdateMode::ramped)
+            smoothedPassKernels[(size_t) pass](getSmoothedSection(group, firstSection), frame, numOversampledSamples, rampSamplesRemaining);
+        else
+            passKernels[(size_t) pass](getSection(group, firstSection), frame, numOversampledSamples);
+    }
+
+    downsample(group, frame, numSamples);
+    deinterleave(groupBlock, frame, groupMidSide);
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::upsample(int group, SampleType* frame, size_t numSamples)
+{
+    const auto& stages = getHalfBandStages();
+    const auto lanes = (size_t) numLanes;
+    const auto totalFrames = numSamples * (size_t) oversamplingFactor;
+
+    // Each stage reads the second half of what it writes
+    for (int stage = 0; stage < numOversamplingStages; ++stage, numSamples *= 2)
+    {
+        const auto& halfBand = stages[(size_t) stage];
+        auto* output = frame + (totalFrames - 2 * numSamples) * lanes;
+
+        cascadeKernels->upsampleHalfBand(halfBand.getCoefficients<SampleType>(), halfBand.numCoefficients,
+                                         getHalfBandState(group, stage, false),
+                                         output + numSamples * lanes, output, numSamples);
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::downsample(int group, SampleType* frame, size_t numSamples)
+{
+    const auto& stages = getHalfBandStages();
+
+    for (int stage = numOversamplingStages - 1; stage >= 0; --stage)
+    {
+        const auto& halfBand = stages[(size_t) stage];
+
+        cascadeKernels->downsampleHalfBand(halfBand.getCoefficients<SampleType>(), halfBand.numCoefficients,
+                                           getHalfBandState(group, stage, true), frame, frame, numSamples << stage);
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::encodeMidSide(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto* left = block.getChannelPointer(0);
+    auto* right = block.getChannelPointer(1);
+
+    for (size_t i = 0; i < block.getNumSamples(); ++i)
+    {
+        const auto mid = (left[i] + right[i]) * SampleType(0.5);
+        const auto side = (left[i] - right[i]) * SampleType(0.5);
+        left[i] = mid;
+        right[i] = side;
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::decodeMidSide(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto* mid = block.getChannelPointer(0);
+    auto* side = block.getChannelPointer(1);
+
+    for (size_t i = 0; i < block.getNumSamples(); ++i)
+    {
+        const auto left = mid[i] + side[i];
+        const auto right = mid[i] - side[i];
+        mid[i] = left;
+        side[i] = right;
+    }
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    const auto separateMidSide = midSide && ! encodesMidSideInGroups() && block.getNumChannels() >= 2;
+
+    if (separateMidSide)
+        encodeMidSide(block);
+
+    for (int group = 0; group < getNumLaneGroups(block); ++group)
+        processLaneGroup(block, group);
+
+    if (separateMidSide)
+        decodeMidSide(block);
+
+    advanceTransitions(block.getNumSamples());
+}
+
+template<typename SampleType>
+void BiquadCascade<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block, ChannelWorkerPool& workerPool)
+{
+    struct Job
+    {
+        BiquadCascade& cascade;
+        const juce::dsp::AudioBlock<SampleType>& block;
+    };
+
+    const auto separateMidSide = midSide && ! encodesMidSideInGroups() && block.getNumChannels() >= 2;
+
+    if (separateMidSide)
+        encodeMidSide(block);
+
+    Job job { *this, block };
+
+    workerPool.run(getNumLaneGroups(block), [](void* context, int group)
+    {
+        auto& j = *static_cast<Job*>(context);
+        j.cascade.processLaneGroup(j.block, group);
+    }, &job);
+
+    if (separateMidSide)
+        decodeMidSide(block);
+
+    advanceTransitions(block.getNumSamples());
+}
+
+template struct BiquadCascade<float>;
+template struct BiquadCascade<double>;
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <type_traits>
+
+#include "ChannelWorkerPool.h"
+#include "CoefficientDesigner.h"
+#include "SIMDKernels.h"
+
+/*  Runs the LowCut -> Peak -> HighCut cascade for any number of channels.
+    Each channel occupies one lane of a SIMD vector, so a whole group of
+    channels (a stereo pair, or a 7.1.4 bed on AVX-512) is filtered with a
+    single pass over the cascade. Layouts wider than the vector are split into
+    groups of lanes that share the coefficients but keep their own state.
+
+    Only the active second order sections are kept, packed into one contiguous
+    array: the cut slopes in use and whichever of the peak bands aren't
+    bypassed. Each pass runs up to SIMDKernels::MaxSectionsPerPass of them
+    over the block, every sample through all of them before moving on. The
+    loop over sections is a template on the section count, picked from a table
+    whenever the slope or bypass settings change, so it has no branches and
+    can be fully unrolled.
+
+    The kernels are built once per instruction set and picked at prepare time
+    (see SIMDKernels.h); the lane count follows the variant in use.
+
+    How new coefficients take over depends on the UpdateMode:
+    - ramped runs the same sections as state variable filters, and glides g, k
+      and the output mix linearly to each new design. That form stays stable
+      while its parameters move, so automation sweeps don't click.
+    - crossfade splits every vector into two chains for the length of a fade,
+      the old coefficients in the lower half of the lanes and the new ones in
+      the upper half, and fades from one to the other. Both run in the same
+      pass. In between fades each vector holds one chain again.
+
+    The cascade can also run at 2x or 4x the host rate, so the peak doesn't
+    cramp towards Nyquist. The interleaved frames go through polyphase IIR
+    half-band filters on the way up and down, so every lane is resampled at
+    once, in place, with the same kernels as the cascade. Coefficients must be
+    designed for the oversampled rate.
+
+    Channel 1 takes its coefficients from the second channel set and every
+    other channel from the first (see getChannelSet()). In mid/side mode the
+    first two channels are encoded on the way into the frames and decoded on
+    the way out, so it costs no extra pass over the block.
+
+    SampleType is float or double. The double version keeps its coefficients,
+    state and arithmetic in double, with half as many lanes per vector.
+*/
+struct BiquadCascadeBase
+{
+    // LowCut sections, then the peak bands, then HighCut sections
+    static constexpr int FirstPeakSection = ChainCoefficients::MaxCutSections;
+    static constexpr int FirstHighCutSection = FirstPeakSection + ChainCoefficients::MaxPeakBands;
+    static constexpr int MaxSections = FirstHighCutSection + ChainCoefficients::MaxCutSections;
+    static constexpr int MaxPasses = (MaxSections + SIMDKernels::MaxSectionsPerPass - 1) / SIMDKernels::MaxSectionsPerPass;
+
+    static constexpr int MaxOversamplingFactor = 4;
+
+    enum class UpdateMode
+    {
+        immediate,
+        ramped,
+        crossfade
+    };
+
+    // Delay added by the half-band filters, in host samples. Not a whole number.
+    static double getOversamplingLatency(int factor);
+
+    // Host samples until the half-band filters' ringing decays below threshold
+    static double getOversamplingTailLength(int factor, double threshold);
+};
+
+template<typename SampleType>
+struct BiquadCascade : BiquadCascadeBase
+{
+    static constexpr bool isDoublePrecision = std::is_same_v<SampleType, double>;
+
+    // Uses the narrowest supported variants with a lane for every channel
+    // (two lanes per channel when crossfading)
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void prepare(const juce::dsp::ProcessSpec& spec, const SIMDKernels::KernelSet& kernelsToUse);
+    void reset();
+
+    size_t getMaxNumChannels() const { return (size_t) numChannels; }
+    int getNumLanes() const { return numLanes; }
+    int getNumLaneGroups() const { return numGroups; }
+    int getMaxNumLaneGroups() const { return juce::jmax(directLayout.numGroups, crossfadeLayout.numGroups); }
+    const SIMDKernels::KernelSet& getKernelSet() const { return *kernels; }
+
+    // Switching mode restarts the filter state. transitionLengthInSamples is
+    // the length of a ramp or crossfade at the host rate.
+    void setUpdateMode(UpdateMode newMode, int transitionLengthInSamples);
+    UpdateMode getUpdateMode() const { return mode; }
+
+    // New coefficients should wait until this is false; any applied during a
+    // fade replace the new chain's coefficients without fading
+    bool isCrossfading() const { return fadeSamplesRemaining > 0; }
+
+    // 1, 2 or 4. Changing it restarts the filter state.
+    void setOversamplingFactor(int newFactor);
+    int getOversamplingFactor() const { return oversamplingFactor; }
+
+    // Copies the stages flagged in stagesToApply (indexed by ChainPositions)
+    // for both channel sets. Switching in or out of mid/side restarts the filter state.
+    void setCoefficients(const StereoChainCoefficients& coefficients, const std::array<bool, 3>& stagesToApply);
+
+    // Filters up to getMaxNumChannels() channels in place
+    void process(const juce::dsp::AudioBlock<SampleType>& block);
+
+    // Same, with the lane groups shared out across workerPool
+    void process(const juce::dsp::AudioBlock<SampleType>& block, ChannelWorkerPool& workerPool);
+
+    // Lane groups touch disjoint channels and state, so any number of them
+    // can be processed concurrently, but not concurrently with setCoefficients()
+    int getNumLaneGroups(const juce::dsp::AudioBlock<SampleType>& block) const;
+    void processLaneGroup(const juce::dsp::AudioBlock<SampleType>& block, int group);
+private:
+    struct Layout
+    {
+        const SIMDKernels::KernelSet* kernels;
+        int numLanes;
+        int lanesPerChain;  // Channels per group
+        int numGroups;
+    };
+
+    Layout directLayout { &SIMDKernels::getKernelSetForChannels(2, isDoublePrecision), 0, 0, 0 };
+    Layout crossfadeLayout = directLayout;
+
+    // The layout in use
+    const SIMDKernels::KernelSet* kernels = directLayout.kernels;
+    const SIMDKernels::CascadeKernels<SampleType>* cascadeKernels = &kernels->template getCascadeKernels<SampleType>();
+    int numLanes = cascadeKernels->numLanes;
+    int lanesPerChain = numLanes;
+    int numChannels = 0;
+    int numGroups = 0;
+
+    UpdateMode mode = UpdateMode::immediate;
+    size_t transitionLength = 0;
+
+    int oversamplingFactor = 1;
+    int numOversamplingStages = 0;
+    bool skipNextTransition = false;
+
+    // Every slot of the cascade, active or not, in chain order
+    struct Slots
+    {
+        std::array<BiquadCoefficients, MaxSections> coefficients;
+        std::array<bool, MaxSections> active {};
+    };
+
+    // One per channel set
+    std::array<Slots, NumChannelSets> slots;
+    bool midSide = false;
+
+    // The active slots packed together, as processed
+    std::array<int, MaxSections> packedSlots {};
+    int numActiveSections = 0;
+
+    // The kernel for each pass over the frames
+    int numPasses = 0;
+    std::array<SIMDKernels::CascadeKernel<SampleType>, MaxPasses> passKernels {};
+    std::array<SIMDKernels::SmoothedCascadeKernel<SampleType>, MaxPasses> smoothedPassKernels {};
+
+    // Ramping: the state variable parameters each packed section is heading for, per channel set
+    using SVFTargets = std::array<std::array<double, SIMDKernels::NumSVFParameters>, MaxSections>;
+    size_t rampSamplesRemaining = 0;
+    std::array<SVFTargets, NumChannelSets> smoothedTargets {};
+
+    // Crossfading: the slots the old chain is still running
+    std::array<Slots, NumChannelSets> fadeFromSlots;
+    size_t fadeLength = 0, fadeSamplesRemaining = 0;
+
+    // Sections in the SIMDKernels layout, one run of MaxSections per lane group,
+    // a spare copy to repack from, and each group of the block interleaved a
+    // frame of numLanes samples at a time. Sized for the larger layout.
+    juce::HeapBlock<char> sectionData, previousSectionData, frameData;
+    juce::dsp::AudioBlock<SampleType> sections, previousSections, frames;
+
+    // The same again in the SVFRow layout, used while ramping
+    juce::HeapBlock<char> smoothedSectionData, previousSmoothedSectionData;
+    juce::dsp::AudioBlock<SampleType> smoothedSections, previousSmoothedSections;
+
+    // Half-band filter state for each lane group, oversampling stage and direction.
+    // Frames are sized for MaxOversamplingFactor.
+    juce::HeapBlock<char> halfBandStateData, previousHalfBandStateData;
+    juce::dsp::AudioBlock<SampleType> halfBandStates, previousHalfBandStates;
+
+    void prepareLayouts(const juce::dsp::ProcessSpec& spec,
+                        const SIMDKernels::KernelSet& directKernels,
+                        const SIMDKernels::KernelSet& crossfadeKernels);
+    void useLayout(const Layout& layout);
+
+    // Switches layout, moving each channel's filter state to its lanes in the
+    // new one: from the given chain of the current layout, into every chain
+    // of the new one. The sections have to be packed again afterwards.
+    void moveStateToLayout(const Layout& layout, int fromChain);
+    int getNumChains() const { return numLanes / lanesPerChain; }
+
+    size_t getGroupSize() const;
+    SampleType* getSection(int group, int packedIndex) const;
+    size_t getSmoothedGroupSize() const;
+    SampleType* getSmoothedSection(int group, int packedIndex) const;
+    SampleType* getHalfBandState(int group, int stage, bool downsampling) const;
+
+    void setSlot(int channelSet, int slot, const BiquadCoefficients& coefficients, bool active);
+
+    // Channel set of a lane within a chain
+    int getLaneChannelSet(int group, int laneInChain) const { return getChannelSet((size_t) (group * lanesPerChain + laneInChain)); }
+
+    // Mid/side is folded into interleaving when a group holds both channels;
+    // otherwise it takes a pass of its own over the block
+    bool encodesMidSideInGroups() const { return lanesPerChain >= 2; }
+    static void encodeMidSide(const juce::dsp::AudioBlock<SampleType>& block);
+    static void decodeMidSide(const juce::dsp::AudioBlock<SampleType>& block);
+    void packSections();
+    void packDirectSections(const std::array<int, MaxSections>& previousIndex);
+    void packSmoothedSections(const std::array<int, MaxSections>& previousIndex);
+
+    void upsample(int group, SampleType* frame, size_t numSamples);
+    void downsample(int group, SampleType* frame, size_t numSamples);
+
+    void advanceTransitions(size_t numSamples);
+    void finishRamp();
+    void finishCrossfade();
+
+    // block holds the channels of one lane group; with midSideChannels, its
+    // first two are encoded into mid and side and decoded again
+    void interleave(const juce::dsp::AudioBlock<SampleType>& block, SampleType* frame, bool midSideChannels);
+    void deinterleave(const juce::dsp::AudioBlock<SampleType>& block, const SampleType* frame, bool midSideChannels);
+};
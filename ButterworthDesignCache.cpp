@@ -0,0 +1,56 @@
+#include "ButterworthDesignCache.h"
+
+size_t ButterworthDesignCache::KeyHash::operator()(const Key& key) const
+{
+    auto hash = std::hash<float>()(key.frequency);
+    hash = hash * 31 + std::hash<double>()(key.sampleRate);
+    hash = hash * 31 + std::hash<int>()(key.order);
+    return hash * 31 + (size_t) key.type;
+}
+
+ButterworthDesignCache::Design ButterworthDesignCache::getHighPass(float frequency, double sampleRate, int order)
+{
+    return get({ Type::highPass, frequency, sampleRate, order });
+}
+
+ButterworthDesignCache::Design ButterworthDesignCache::getLowPass(float frequency, double sampleRate, int order)
+{
+    return get({ Type::lowPass, frequency, sampleRate, order });
+}
+
+ButterworthDesignCache::Design ButterworthDesignCache::get(const Key& key)
+{
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto found = index.find(key); found != index.end())
+        {
+            entries.splice(entries.begin(), entries, found->second);
+            ++hits;
+            return found->second->second;
+        }
+    }
+
+    ++misses;
+
+    auto design = key.type == Type::highPass
+                ? juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(key.frequency, key.sampleRate, key.order)
+                : juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(key.frequency, key.sampleRate, key.order);
+
+    const juce::ScopedLock sl(lock);
+
+    // Another caller may have designed the same thing in the meantime
+    if (index.find(key) == index.end())
+    {
+        entries.emplace_front(key, design);
+        index.emplace(key, entries.begin());
+
+        if (entries.size() > capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    return design;
+}
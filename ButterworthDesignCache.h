@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+/*  Bounded LRU cache of high order Butterworth designs, keyed by
+    (type, frequency, sample rate, order). Shared by the processor and the
+    editor through a juce::SharedResourcePointer, so automation sweeping back
+    and forth, or the response curve redrawing, redesigns nothing it has seen
+    recently.
+
+    The cached coefficients are shared, so callers must copy them rather than
+    modify them in place (updateCoefficients() already does).
+*/
+class ButterworthDesignCache
+{
+public:
+    using Design = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
+
+    static constexpr size_t capacity = 256;
+
+    // Thread safe; designs outside the lock, so never blocks on another caller's design
+    Design getHighPass(float frequency, double sampleRate, int order);
+    Design getLowPass(float frequency, double sampleRate, int order);
+
+    juce::uint64 getNumHits() const { return hits.load(std::memory_order_relaxed); }
+    juce::uint64 getNumMisses() const { return misses.load(std::memory_order_relaxed); }
+private:
+    enum class Type { highPass, lowPass };
+
+    struct Key
+    {
+        Type type;
+        float frequency;
+        double sampleRate;
+        int order;
+
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && frequency == other.frequency
+                && sampleRate == other.sampleRate && order == other.order;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    using Entries = std::list<std::pair<Key, Design>>;
+
+    juce::CriticalSection lock;
+    Entries entries;    // Most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+
+    std::atomic<juce::uint64> hits { 0 }, misses { 0 };
+
+    Design get(const Key& key);
+};
@@ -0,0 +1,133 @@
+#include "ChannelWorkerPool.h"
+
+ChannelWorkerPool::Worker::Worker(ChannelWorkerPool& p) : juce::Thread("EQ channel worker"), pool(p)
+{
+}
+
+void ChannelWorkerPool::Worker::run()
+{
+    auto lastGeneration = (juce::uint32) (pool.claimState.load(std::memory_order_acquire) >> 32);
+    auto lastRunCount = pool.runCount.load(std::memory_order_relaxed);
+    auto lastActivityTime = juce::Time::getMillisecondCounter();
+
+    while (! threadShouldExit())
+    {
+        const auto batchGeneration = (juce::uint32) (pool.claimState.load(std::memory_order_acquire) >> 32);
+
+        if (batchGeneration != lastGeneration)
+        {
+            lastGeneration = batchGeneration;
+            while (pool.runNextTask(batchGeneration, true)) {}
+        }
+
+        if (const auto count = pool.runCount.load(std::memory_order_relaxed); count != lastRunCount)
+        {
+            lastRunCount = count;
+            lastActivityTime = juce::Time::getMillisecondCounter();
+        }
+
+        // The next batch usually follows a block later, so keep watching for it
+        // while the audio thread is busy, and sleep once it has gone quiet
+        if (juce::Time::getMillisecondCounter() - lastActivityTime < spinTimeMs)
+            juce::Thread::yield();
+        else
+            wait(idleWaitMs);
+    }
+}
+
+//==============================================================================
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    setNumWorkers(0);
+}
+
+void ChannelWorkerPool::setNumWorkers(int numWorkers)
+{
+    numWorkers = juce::jmax(0, numWorkers);
+
+    while (workers.size() > numWorkers)
+    {
+        // The worker sees the exit flag by its next check, after any task it has claimed
+        workers.getLast()->stopThread(1000);
+        workers.removeLast();
+    }
+
+    while (workers.size() < numWorkers)
+    {
+        auto* worker = workers.add(new Worker(*this));
+        worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+bool ChannelWorkerPool::runNextTask(juce::uint32 batchGeneration, bool onWorker)
+{
+    auto state = claimState.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        // A task can only be claimed while its batch is still the current one and
+        // has tasks left. The next batch's function and context are only written
+        // once every task of this one has been claimed, so if the claim succeeds
+        // they belong to this batch.
+        if ((juce::uint32) (state >> 32) != batchGeneration)
+            return false;
+
+        const auto numTasks = (int) ((state >> 16) & maxTasksPerBatch);
+        const auto taskIndex = (int) (state & maxTasksPerBatch);
+        if (taskIndex >= numTasks)
+            return false;
+
+        auto* task = taskFunction.load(std::memory_order_relaxed);
+        auto* context = taskContext.load(std::memory_order_relaxed);
+
+        if (claimState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            task(context, taskIndex);
+
+            if (onWorker)
+                tasksRunByWorkers.fetch_add(1, std::memory_order_relaxed);
+
+            completedTasks.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+void ChannelWorkerPool::run(int numTasks, TaskFunction task, void* context)
+{
+    runCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (fallbackBlocksRemaining > 0)
+        --fallbackBlocksRemaining;
+
+    jassert(numTasks <= maxTasksPerBatch);
+
+    if (workers.isEmpty() || numTasks < 2 || numTasks > maxTasksPerBatch || fallbackBlocksRemaining > 0)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task(context, i);
+
+        return;
+    }
+
+    taskFunction.store(task, std::memory_order_relaxed);
+    taskContext.store(context, std::memory_order_relaxed);
+    completedTasks.store(0, std::memory_order_relaxed);
+    tasksRunByWorkers.store(0, std::memory_order_relaxed);
+
+    ++generation;
+
+    // Publishing the batch is all it takes; a worker that's asleep or busy
+    // elsewhere is covered by the audio thread taking its tasks
+    claimState.store(((juce::uint64) generation << 32) | ((juce::uint64) numTasks << 16), std::memory_order_release);
+
+    while (runNextTask(generation, false)) {}
+
+    // Spin until the tasks the workers claimed have finished
+    while (completedTasks.load(std::memory_order_acquire) < numTasks)
+        juce::Thread::yield();
+
+    // If the workers never got a look in, the cores are busy; stop handing them batches for a while
+    if (tasksRunByWorkers.load(std::memory_order_relaxed) == 0)
+        fallbackBlocksRemaining = fallbackBlocks;
+}
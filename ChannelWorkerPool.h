@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+
+/*  A small pool of pre-spawned threads that the audio thread can hand a batch
+    of independent tasks to, e.g. one per lane group of a wide bus.
+
+    Tasks are claimed through a single atomic counter, and workers find new
+    batches by watching it rather than being signalled, so nothing on the audio
+    thread allocates or takes a lock. Workers spin while the audio thread is
+    calling run() and drop back to short sleeps once it stops. The audio
+    thread always joins in and claims tasks itself; it only ever waits for
+    tasks a worker has already started. A worker that wakes late therefore
+    costs nothing, and when the host is already using every core the whole
+    batch simply runs on the audio thread.
+*/
+class ChannelWorkerPool
+{
+public:
+    using TaskFunction = void (*)(void* context, int taskIndex);
+
+    ChannelWorkerPool() = default;
+    ~ChannelWorkerPool();
+
+    // Starts or stops workers so numWorkers are running. Not realtime safe.
+    void setNumWorkers(int numWorkers);
+    int getNumWorkers() const { return workers.size(); }
+
+    // Runs task(context, i) for i in [0, numTasks) and returns once all of
+    // them have finished. Call from the audio thread only.
+    void run(int numTasks, TaskFunction task, void* context);
+private:
+    struct Worker : juce::Thread
+    {
+        explicit Worker(ChannelWorkerPool& p);
+        void run() override;
+
+        ChannelWorkerPool& pool;
+    };
+
+    juce::OwnedArray<Worker> workers;
+
+    // Generation in the top 32 bits, then the batch's task count and the next
+    // unclaimed task, 16 bits each. Everything a claim is checked against is
+    // in the one word, so a late worker holding an old state can never pair
+    // it with a newer batch's task count, and its claim fails once the state
+    // moves on.
+    static constexpr int maxTasksPerBatch = 0xffff;
+    std::atomic<juce::uint64> claimState { 0 };
+    std::atomic<TaskFunction> taskFunction { nullptr };
+    std::atomic<void*> taskContext { nullptr };
+    std::atomic<int> completedTasks { 0 };
+    std::atomic<int> tasksRunByWorkers { 0 };
+
+    // Bumped by every run(), batch or not, so workers keep spinning through
+    // blocks run single threaded
+    std::atomic<juce::uint32> runCount { 0 };
+
+    // Workers spin this long after the audio thread last called run(), then
+    // check back every idleWaitMs
+    static constexpr juce::uint32 spinTimeMs = 20;
+    static constexpr int idleWaitMs = 1;
+
+    // Audio thread only
+    juce::uint32 generation = 0;
+    int fallbackBlocksRemaining = 0;
+
+    // Blocks to run single threaded after a batch the workers never got to
+    static constexpr int fallbackBlocks = 32;
+
+    bool runNextTask(juce::uint32 batchGeneration, bool onWorker);
+};
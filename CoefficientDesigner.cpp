@@ -0,0 +1,331 @@
+#include "CoefficientDesigner.h"
+#include "PluginProcessor.h"
+
+template<typename SampleType>
+static BiquadCoefficients toBiquad(const juce::dsp::IIR::Coefficients<SampleType>& coefficients)
+{
+    // IIR::Coefficients stores b0, b1, b2, a1, a2 for a second order section
+    jassert(coefficients.getFilterOrder() == 2);
+    auto* raw = coefficients.coefficients.begin();
+
+    return { raw[0], raw[1], raw[2], raw[3], raw[4] };
+}
+
+template<typename CoefficientArray>
+static int copyCutSections(const CoefficientArray& designed,
+                           std::array<BiquadCoefficients, ChainCoefficients::MaxCutSections>& sections)
+{
+    auto numSections = juce::jmin(designed.size(), ChainCoefficients::MaxCutSections);
+
+    for (int i = 0; i < numSections; ++i)
+        sections[(size_t) i] = toBiquad(*designed[i]);
+
+    return numSections;
+}
+
+bool designLowCutFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                           const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    const auto order = (chainSettings.lowCutSlope + 1) * 2;
+
+    if (! tables.designHighPass(table, chainSettings.lowCutFreq, order, coefficients.lowCut.data()))
+        return false;
+
+    coefficients.numLowCutSections = order / 2;
+    coefficients.lowCutBypassed = chainSettings.lowCutBypassed;
+    return true;
+}
+
+void designLowCut(const ChainSettings& chainSettings, CoefficientTables& tables,
+                  const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    if (designLowCutFromTable(chainSettings, tables, table, coefficients))
+        return;
+
+    coefficients.numLowCutSections = copyCutSections(makeLowCutFilter(chainSettings, table.sampleRate),
+                                                     coefficients.lowCut);
+    coefficients.lowCutBypassed = chainSettings.lowCutBypassed;
+}
+
+// A band at 0 dB stays in the cascade: dropping it and packing it again
+// from cleared state as automation sweeps through 0 dB would click
+static bool isPeakBandActive(const PeakBandSettings& band)
+{
+    return ! band.bypassed;
+}
+
+bool designPeakFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                         const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+    {
+        const auto band = chainSettings.getPeakBand(i);
+        coefficients.peakActive[(size_t) i] = isPeakBandActive(band);
+
+        if (coefficients.peakActive[(size_t) i]
+            && ! tables.designPeak(table, band.freq, band.quality, band.gainInDecibels, coefficients.peaks[(size_t) i]))
+            return false;
+    }
+
+    return true;
+}
+
+void designPeak(const ChainSettings& chainSettings, CoefficientTables& tables,
+                const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+    {
+        const auto band = chainSettings.getPeakBand(i);
+        auto& peak = coefficients.peaks[(size_t) i];
+        coefficients.peakActive[(size_t) i] = isPeakBandActive(band);
+
+        if (! coefficients.peakActive[(size_t) i])
+            continue;
+
+        if (! tables.designPeak(table, band.freq, band.quality, band.gainInDecibels, peak))
+            peak = toBiquad(*juce::dsp::IIR::Coefficients<float>::makePeakFilter(
+                table.sampleRate, band.freq, band.quality, juce::Decibels::decibelsToGain(band.gainInDecibels)));
+    }
+}
+
+bool designHighCutFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                            const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    const auto order = (chainSettings.highCutSlope + 1) * 2;
+
+    if (! tables.designLowPass(table, chainSettings.highCutFreq, order, coefficients.highCut.data()))
+        return false;
+
+    coefficients.numHighCutSections = order / 2;
+    coefficients.highCutBypassed = chainSettings.highCutBypassed;
+    return true;
+}
+
+void designHighCut(const ChainSettings& chainSettings, CoefficientTables& tables,
+                   const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    if (designHighCutFromTable(chainSettings, tables, table, coefficients))
+        return;
+
+    coefficients.numHighCutSections = copyCutSections(makeHighCutFilter(chainSettings, table.sampleRate),
+                                                      coefficients.highCut);
+    coefficients.highCutBypassed = chainSettings.highCutBypassed;
+}
+
+void designLowCutInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients)
+{
+    const auto order = (chainSettings.lowCutSlope + 1) * 2;
+    coefficients.numLowCutSections = copyCutSections(juce::dsp::FilterDesign<double>::designIIRHighpassHighOrderButterworthMethod(
+                                                         (double) chainSettings.lowCutFreq, sampleRate, order),
+                                                     coefficients.lowCut);
+    coefficients.lowCutBypassed = chainSettings.lowCutBypassed;
+}
+
+void designPeakBandInDoublePrecision(const PeakBandSettings& band, double sampleRate, BiquadCoefficients& coefficients)
+{
+    coefficients = toBiquad(*juce::dsp::IIR::Coefficients<double>::makePeakFilter(
+        sampleRate, (double) band.freq, (double) band.quality,
+        juce::Decibels::decibelsToGain((double) band.gainInDecibels)));
+}
+
+void designPeakInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients)
+{
+    for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+    {
+        const auto band = chainSettings.getPeakBand(i);
+        coefficients.peakActive[(size_t) i] = isPeakBandActive(band);
+
+        if (coefficients.peakActive[(size_t) i])
+            designPeakBandInDoublePrecision(band, sampleRate, coefficients.peaks[(size_t) i]);
+    }
+}
+
+void designHighCutInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients)
+{
+    const auto order = (chainSettings.highCutSlope + 1) * 2;
+    coefficients.numHighCutSections = copyCutSections(juce::dsp::FilterDesign<double>::designIIRLowpassHighOrderButterworthMethod(
+                                                          (double) chainSettings.highCutFreq, sampleRate, order),
+                                                      coefficients.highCut);
+    coefficients.highCutBypassed = chainSettings.highCutBypassed;
+}
+
+bool haveSameStageSettings(const ChainSettings& first, const ChainSettings& second, int stage)
+{
+    switch (stage)
+    {
+        case ChainPositions::LowCut:
+            return first.lowCutFreq == second.lowCutFreq && first.lowCutSlope == second.lowCutSlope
+                && first.lowCutBypassed == second.lowCutBypassed;
+        case ChainPositions::Peak:
+            for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+            {
+                const auto a = first.getPeakBand(i), b = second.getPeakBand(i);
+                if (a.freq != b.freq || a.gainInDecibels != b.gainInDecibels
+                    || a.quality != b.quality || a.bypassed != b.bypassed)
+                    return false;
+            }
+            return true;
+        case ChainPositions::HighCut:
+            return first.highCutFreq == second.highCutFreq && first.highCutSlope == second.highCutSlope
+                && first.highCutBypassed == second.highCutBypassed;
+        default:
+            return false;
+    }
+}
+
+void copyStage(const ChainCoefficients& source, int stage, ChainCoefficients& destination)
+{
+    switch (stage)
+    {
+        case ChainPositions::LowCut:
+            destination.lowCut = source.lowCut;
+            destination.numLowCutSections = source.numLowCutSections;
+            destination.lowCutBypassed = source.lowCutBypassed;
+            break;
+        case ChainPositions::Peak:
+            destination.peaks = source.peaks;
+            destination.peakActive = source.peakActive;
+            break;
+        case ChainPositions::HighCut:
+            destination.highCut = source.highCut;
+            destination.numHighCutSections = source.numHighCutSections;
+            destination.highCutBypassed = source.highCutBypassed;
+            break;
+        default:
+            break;
+    }
+}
+
+double getMagnitudeForFrequency(const BiquadCoefficients& coefficients, double frequency, double sampleRate)
+{
+    const auto jw = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+    const auto numerator = coefficients.b0 + jw * (coefficients.b1 + jw * coefficients.b2);
+    const auto denominator = 1.0 + jw * (coefficients.a1 + jw * coefficients.a2);
+
+    return std::abs(numerator / denominator);
+}
+
+double getMagnitudeForFrequency(const ChainCoefficients& coefficients, double frequency)
+{
+    const auto sampleRate = coefficients.sampleRate;
+    auto magnitude = 1.0;
+
+    if (! coefficients.lowCutBypassed)
+        for (int i = 0; i < coefficients.numLowCutSections; ++i)
+            magnitude *= getMagnitudeForFrequency(coefficients.lowCut[(size_t) i], frequency, sampleRate);
+
+    for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+        if (coefficients.peakActive[(size_t) i])
+            magnitude *= getMagnitudeForFrequency(coefficients.peaks[(size_t) i], frequency, sampleRate);
+
+    if (! coefficients.highCutBypassed)
+        for (int i = 0; i < coefficients.numHighCutSections; ++i)
+            magnitude *= getMagnitudeForFrequency(coefficients.highCut[(size_t) i], frequency, sampleRate);
+
+    return magnitude;
+}
+
+bool isEffectivelyFlat(const ChainSettings& chainSettings, const ChainCoefficients& coefficients)
+{
+    constexpr double lowestFrequency = 20, highestFrequency = 20000;
+    constexpr int numPoints = 64;
+
+    auto audible = coefficients;
+    audible.lowCutBypassed = audible.lowCutBypassed || chainSettings.lowCutFreq <= lowestFrequency;
+    audible.highCutBypassed = audible.highCutBypassed || chainSettings.highCutFreq >= highestFrequency;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto frequency = lowestFrequency * std::pow(highestFrequency / lowestFrequency, (double) i / (numPoints - 1));
+        if (frequency >= coefficients.sampleRate / 2)
+            break;
+
+        const auto decibels = juce::Decibels::gainToDecibels(getMagnitudeForFrequency(audible, frequency));
+        if (std::abs(decibels) > flatToleranceDecibels)
+            return false;
+    }
+
+    return true;
+}
+
+double getTailLengthInSamples(const BiquadCoefficients& coefficients, double threshold)
+{
+    // Poles are the roots of z^2 + a1 z + a2
+    const auto a1 = coefficients.a1, a2 = coefficients.a2;
+    const auto discriminant = a1 * a1 - 4 * a2;
+
+    const auto radius = discriminant < 0 ? std::sqrt(a2)
+                                         : (std::abs(a1) + std::sqrt(discriminant)) / 2;
+
+    if (radius >= 1)
+        return std::numeric_limits<double>::infinity();
+
+    // Only zeros: done once the two samples of state have gone through
+    if (radius <= 0)
+        return 2;
+
+    return 2 + std::log(threshold) / std::log(radius);
+}
+
+double getTailLengthInSamples(const ChainCoefficients& coefficients, double threshold)
+{
+    auto samples = 0.0;
+
+    if (! coefficients.lowCutBypassed)
+        for (int i = 0; i < coefficients.numLowCutSections; ++i)
+            samples += getTailLengthInSamples(coefficients.lowCut[(size_t) i], threshold);
+
+    for (int i = 0; i < ChainCoefficients::MaxPeakBands; ++i)
+        if (coefficients.peakActive[(size_t) i])
+            samples += getTailLengthInSamples(coefficients.peaks[(size_t) i], threshold);
+
+    if (! coefficients.highCutBypassed)
+        for (int i = 0; i < coefficients.numHighCutSections; ++i)
+            samples += getTailLengthInSamples(coefficients.highCut[(size_t) i], threshold);
+
+    return samples;
+}
+
+double getTailLengthInSamples(const StereoChainCoefficients& coefficients, double threshold)
+{
+    return juce::jmax(getTailLengthInSamples(coefficients.channelSets[0], threshold),
+                      getTailLengthInSamples(coefficients.channelSets[1], threshold));
+}
+
+//======================================================================
+CoefficientDesignerThread::CoefficientDesignerThread() : juce::Thread("EQ coefficient designer")
+{
+    startThread();
+}
+
+CoefficientDesignerThread::~CoefficientDesignerThread()
+{
+    stopThread(1000);
+}
+
+void CoefficientDesignerThread::addClient(Client* client)
+{
+    const juce::ScopedLock sl(clientLock);
+    clients.addIfNotAlreadyThere(client);
+}
+
+void CoefficientDesignerThread::removeClient(Client* client)
+{
+    // Once this returns the client is guaranteed not to be in designPendingCoefficients()
+    const juce::ScopedLock sl(clientLock);
+    clients.removeFirstMatchingValue(client);
+}
+
+void CoefficientDesignerThread::run()
+{
+    while (! threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(clientLock);
+            for (auto* client : clients)
+                client->designPendingCoefficients();
+        }
+
+        wait(pollIntervalMs);
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+
+#include "CoefficientTables.h"
+
+struct ChainSettings;
+struct PeakBandSettings;
+
+//======================================================================
+// Plain coefficient storage that can be copied around without touching the heap
+struct BiquadCoefficients
+{
+    // Normalised so that a0 == 1, same layout as juce::dsp::IIR::Coefficients.
+    // Double so that designs for the double precision path keep every bit.
+    double b0 {1}, b1 {0}, b2 {0}, a1 {0}, a2 {0};
+};
+
+struct ChainCoefficients
+{
+    static constexpr int MaxCutSections = 4;
+    static constexpr int MaxPeakBands = 16;     // "Peak", then the "Peak N" bands
+
+    std::array<BiquadCoefficients, MaxCutSections> lowCut, highCut;
+    std::array<BiquadCoefficients, MaxPeakBands> peaks;
+    int numLowCutSections {0}, numHighCutSections {0};
+    bool lowCutBypassed { false }, highCutBypassed { false };
+    std::array<bool, MaxPeakBands> peakActive {};   // Off when bypassed
+
+    double sampleRate {0};
+    bool isFlat { false };  // See isEffectivelyFlat()
+
+    // Incremented every time a stage is redesigned, indexed by ChainPositions
+    std::array<juce::uint32, 3> stageRevisions { 0, 0, 0 };
+};
+
+// Choices of the "Stereo Mode" parameter
+enum class StereoMode
+{
+    stereo,     // Both channels use the first set of settings
+    midSide,    // The first set filters the mid signal, the second the side
+    dualMono    // The first set filters the left channel, the second the right
+};
+
+// The first channel set feeds channel 0 (left or mid) and any channels past
+// the second; the second set feeds channel 1 (right or side)
+constexpr int NumChannelSets = 2;
+
+inline int getChannelSet(size_t channel) { return channel == 1 ? 1 : 0; }
+
+struct StereoChainCoefficients
+{
+    StereoMode mode = StereoMode::stereo;
+    std::array<ChainCoefficients, NumChannelSets> channelSets;
+
+    bool isFlat() const { return channelSets[0].isFlat && channelSets[1].isFlat; }
+};
+
+// Look the trigonometric terms up in table, falling back to the JUCE designers
+// off the grid. designPeak() designs every peak band.
+void designLowCut(const ChainSettings& chainSettings, CoefficientTables& tables,
+                  const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+void designPeak(const ChainSettings& chainSettings, CoefficientTables& tables,
+                const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+void designHighCut(const ChainSettings& chainSettings, CoefficientTables& tables,
+                   const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+
+// Table lookups only, so they never lock or allocate, for designing on the
+// audio thread. Return false, with the stage half written, off the grid.
+bool designLowCutFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                           const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+bool designPeakFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                         const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+bool designHighCutFromTable(const ChainSettings& chainSettings, const CoefficientTables& tables,
+                            const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+
+// The JUCE designers run in double precision, for the double processing path
+void designPeakBandInDoublePrecision(const PeakBandSettings& band, double sampleRate, BiquadCoefficients& coefficients);
+void designLowCutInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients);
+void designPeakInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients);
+void designHighCutInDoublePrecision(const ChainSettings& chainSettings, double sampleRate, ChainCoefficients& coefficients);
+
+// Same as IIR::Coefficients::getMagnitudeForFrequency
+double getMagnitudeForFrequency(const BiquadCoefficients& coefficients, double frequency, double sampleRate);
+
+// Used by the designer to design a stage once when both channel sets agree on it
+bool haveSameStageSettings(const ChainSettings& first, const ChainSettings& second, int stage);
+void copyStage(const ChainCoefficients& source, int stage, ChainCoefficients& destination);
+
+// The whole chain at coefficients.sampleRate, leaving out bypassed stages
+double getMagnitudeForFrequency(const ChainCoefficients& coefficients, double frequency);
+
+// True if the chain is within flatToleranceDecibels of unity across the
+// audible band. Cuts parked at its edges only shape what lies outside, so
+// they are left out.
+constexpr double flatToleranceDecibels = 0.05;
+bool isEffectivelyFlat(const ChainSettings& chainSettings, const ChainCoefficients& coefficients);
+
+// Samples until the impulse response of a section has decayed below threshold
+// (a gain), from its slowest pole. Infinite if it doesn't decay.
+double getTailLengthInSamples(const BiquadCoefficients& coefficients, double threshold);
+
+// The sum over the chain's active sections, at coefficients.sampleRate
+double getTailLengthInSamples(const ChainCoefficients& coefficients, double threshold);
+
+// The longer of the two channel sets
+double getTailLengthInSamples(const StereoChainCoefficients& coefficients, double threshold);
+
+//======================================================================
+/*  Single producer, single consumer triple buffer.
+    The writer fills getWriteSlot() and calls publish(); the reader calls
+    acquire() and gets the newest published slot. Neither side ever waits,
+    allocates or sees a slot the other side is using.
+*/
+template<typename T>
+struct TripleBuffer
+{
+    T& getWriteSlot() { return slots[(size_t) writeIndex]; }
+
+    void publish()
+    {
+        writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Returns nullptr if nothing has been published since the last call
+    const T* acquire()
+    {
+        if ((middle.load(std::memory_order_acquire) & freshBit) == 0)
+            return nullptr;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return &slots[(size_t) readIndex];
+    }
+private:
+    static constexpr int freshBit = 4;
+    static constexpr int indexMask = 3;
+
+    std::array<T, 3> slots;
+    std::atomic<int> middle { 1 };
+    int writeIndex = 0;
+    int readIndex = 2;
+};
+
+//======================================================================
+/*  One designer thread shared by every plugin instance in the process.
+    Clients are polled at a fixed interval and redesign whatever changed,
+    so the audio thread only ever picks up finished coefficients.
+*/
+class CoefficientDesignerThread : private juce::Thread
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+        // Called on the designer thread
+        virtual void designPendingCoefficients() = 0;
+    };
+
+    CoefficientDesignerThread();
+    ~CoefficientDesignerThread() override;
+
+    void addClient(Client* client);
+    void removeClient(Client* client);
+
+    // Wakes the thread early. Takes a lock, so never call this from the audio thread.
+    void triggerDesign() { notify(); }
+private:
+    static constexpr int pollIntervalMs = 2;
+
+    juce::CriticalSection clientLock;
+    juce::Array<Client*> clients;
+
+    void run() override;
+};
@@ -0,0 +1,171 @@
+#include "CoefficientTables.h"
+#include "CoefficientDesigner.h"
+
+// Index of a whole-Hz frequency, or -1 if it's off the grid
+static int getFrequencyIndex(float frequency)
+{
+    const auto index = (int) frequency - CoefficientTables::MinFrequency;
+
+    if ((float) (int) frequency != frequency || ! juce::isPositiveAndBelow(index, CoefficientTables::NumFrequencies))
+        return -1;
+
+    return index;
+}
+
+// Q of each section of an even order Butterworth filter, worked out the same
+// way as juce::dsp::FilterDesign
+static float getButterworthQuality(int order, int section)
+{
+    static const auto qualities = []
+    {
+        constexpr auto maxSections = CoefficientTables::MaxCutOrder / 2;
+        std::array<std::array<float, maxSections>, maxSections> q {};
+
+        for (int o = 2; o <= CoefficientTables::MaxCutOrder; o += 2)
+            for (int i = 0; i < o / 2; ++i)
+                q[(size_t) (o / 2 - 1)][(size_t) i] = static_cast<float>(
+                    1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (o * 2.0))));
+
+        return q;
+    }();
+
+    return qualities[(size_t) (order / 2 - 1)][(size_t) section];
+}
+
+//==============================================================================
+size_t CoefficientTables::Table::getSizeInBytes() const
+{
+    return sizeof(Table) + (tanTerms.size() + sinTerms.size() + cosTerms.size()) * sizeof(float);
+}
+
+bool CoefficientTables::designHighPass(const Table& table, float frequency, int order,
+                                      BiquadCoefficients* sections) const
+{
+    const auto index = getFrequencyIndex(frequency);
+    if (index < 0 || order % 2 != 0 || order > MaxCutOrder)
+        return false;
+
+    // IIR::Coefficients::makeHighPass, which already has a0 == 1
+    const auto n = table.tanTerms[(size_t) index];
+    const auto nSquared = n * n;
+
+    for (int i = 0; i < order / 2; ++i)
+    {
+        const auto invQ = 1 / getButterworthQuality(order, i);
+        const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+        sections[i] = { c1, c1 * -2, c1, c1 * 2 * (nSquared - 1), c1 * (1 - invQ * n + nSquared) };
+    }
+
+    return true;
+}
+
+bool CoefficientTables::designLowPass(const Table& table, float frequency, int order,
+                                     BiquadCoefficients* sections) const
+{
+    const auto index = getFrequencyIndex(frequency);
+    if (index < 0 || order % 2 != 0 || order > MaxCutOrder)
+        return false;
+
+    // IIR::Coefficients::makeLowPass, which already has a0 == 1
+    const auto n = 1 / table.tanTerms[(size_t) index];
+    const auto nSquared = n * n;
+
+    for (int i = 0; i < order / 2; ++i)
+    {
+        const auto invQ = 1 / getButterworthQuality(order, i);
+        const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+        sections[i] = { c1, c1 * 2, c1, c1 * 2 * (1 - nSquared), c1 * (1 - invQ * n + nSquared) };
+    }
+
+    return true;
+}
+
+//==============================================================================
+CoefficientTables::CoefficientTables()
+{
+    for (int i = 0; i < NumGains; ++i)
+    {
+        const auto gain = juce::Decibels::decibelsToGain(MinGainDb + (float) i * GainStepDb);
+        gainTerms[(size_t) i] = juce::jmax(0.f, std::sqrt(gain));
+    }
+}
+
+const CoefficientTables::Table& CoefficientTables::getTable(double sampleRate)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto& table = tables[sampleRate];
+
+    if (table == nullptr)
+    {
+        table = std::make_unique<Table>();
+        table->sampleRate = sampleRate;
+        table->tanTerms.resize(NumFrequencies);
+        table->sinTerms.resize(NumFrequencies);
+        table->cosTerms.resize(NumFrequencies);
+
+        // Same float expressions as the JUCE designers
+        constexpr auto pi = juce::MathConstants<float>::pi;
+        const auto rate = static_cast<float>(sampleRate);
+
+        for (int i = 0; i < NumFrequencies; ++i)
+        {
+            const auto frequency = (float) (MinFrequency + i);
+            const auto omega = (2 * pi * juce::jmax(frequency, 2.f)) / rate;
+
+            table->tanTerms[(size_t) i] = std::tan(pi * frequency / rate);
+            table->sinTerms[(size_t) i] = std::sin(omega);
+            table->cosTerms[(size_t) i] = std::cos(omega);
+        }
+    }
+
+    return *table;
+}
+
+bool CoefficientTables::designPeak(const Table& table, float frequency, float quality, float gainDb,
+                                   BiquadCoefficients& coefficients) const
+{
+    const auto index = getFrequencyIndex(frequency);
+    const auto gainPosition = (gainDb - MinGainDb) / GainStepDb;
+    const auto gainIndex = (int) gainPosition;
+
+    if (index < 0 || (float) gainIndex != gainPosition || ! juce::isPositiveAndBelow(gainIndex, NumGains))
+        return false;
+
+    // IIR::Coefficients::makePeakFilter, normalised by a0 the same way
+    const auto A = gainTerms[(size_t) gainIndex];
+    const auto alpha = table.sinTerms[(size_t) index] / (quality * 2);
+    const auto c2 = -2 * table.cosTerms[(size_t) index];
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+    const auto a0Inv = 1 / (1 + alphaOverA);
+
+    coefficients = { (1 + alphaTimesA) * a0Inv, c2 * a0Inv, (1 - alphaTimesA) * a0Inv,
+                     c2 * a0Inv, (1 - alphaOverA) * a0Inv };
+    return true;
+}
+
+size_t CoefficientTables::getTotalSizeInBytes() const
+{
+    const juce::ScopedLock sl(lock);
+
+    size_t total = sizeof(*this);
+    for (auto& [sampleRate, table] : tables)
+        total += table->getSizeInBytes();
+
+    return total;
+}
+
+juce::String CoefficientTables::getMemoryReport() const
+{
+    const juce::ScopedLock sl(lock);
+
+    juce::String report;
+    for (auto& [sampleRate, table] : tables)
+        report << sampleRate << " Hz: " << juce::File::descriptionOfSizeInBytes((juce::int64) table->getSizeInBytes()) << juce::newLine;
+
+    report << "Total: " << juce::File::descriptionOfSizeInBytes((juce::int64) getTotalSizeInBytes());
+    return report;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct BiquadCoefficients;
+
+/*  Every filter parameter is quantised (frequencies to 1 Hz, gain to 0.5 dB),
+    so for a given sample rate the trigonometric part of each design only
+    takes a few thousand distinct values. These are worked out once per sample
+    rate and shared, read-only, by every plugin instance in the process through
+    a juce::SharedResourcePointer. A design is then a handful of multiplies
+    instead of a tan/sin/cos, using the same arithmetic as the JUCE designers
+    so the coefficients come out identical.
+
+    Values off the grid (which the parameter ranges never produce) return
+    false and should fall back to the JUCE designers.
+*/
+class CoefficientTables
+{
+public:
+    // Matches the ranges in createParameterLayout()
+    static constexpr int MinFrequency = 20;
+    static constexpr int MaxFrequency = 20000;
+    static constexpr int NumFrequencies = MaxFrequency - MinFrequency + 1;
+
+    static constexpr float MinGainDb = -24.f;
+    static constexpr float GainStepDb = 0.5f;
+    static constexpr int NumGains = 97;
+
+    static constexpr int MaxCutOrder = 8;
+
+    struct Table
+    {
+        double sampleRate;
+
+        // Per 1 Hz step: tan(pi f / fs) for the cut filters, and sin/cos of
+        // the peak filter's omega
+        std::vector<float> tanTerms, sinTerms, cosTerms;
+
+        size_t getSizeInBytes() const;
+    };
+
+    CoefficientTables();
+
+    // Builds the table the first time a sample rate is asked for. Takes a
+    // lock, so never call this from the audio thread.
+    const Table& getTable(double sampleRate);
+
+    // Both write one section per 12 dB/Oct into sections, as
+    // designIIR{High,Low}passHighOrderButterworthMethod would
+    bool designHighPass(const Table& table, float frequency, int order, BiquadCoefficients* sections) const;
+    bool designLowPass(const Table& table, float frequency, int order, BiquadCoefficients* sections) const;
+
+    // Same as IIR::Coefficients::makePeakFilter with a decibel gain
+    bool designPeak(const Table& table, float frequency, float quality, float gainDb,
+                    BiquadCoefficients& coefficients) const;
+
+    // One line per sample rate built so far, with what it costs
+    juce::String getMemoryReport() const;
+    size_t getTotalSizeInBytes() const;
+private:
+    juce::CriticalSection lock;
+    std::map<double, std::unique_ptr<Table>> tables;
+
+    // sqrt of the linear gain for each 0.5 dB step
+    std::array<float, NumGains> gainTerms;
+};
@@ -0,0 +1,217 @@
+#include "LinearPhaseFilter.h"
+
+LinearPhaseFilter::LinearPhaseFilter() : juce::Thread("EQ linear phase designer")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+LinearPhaseFilter::~LinearPhaseFilter()
+{
+    stopThread(4000);
+}
+
+void LinearPhaseFilter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    const juce::ScopedLock sl(convolutionLock);
+
+    while (convolutions.size() < (int) spec.numChannels)
+        convolutions.add(new juce::dsp::Convolution(juce::dsp::Convolution::Latency { 0 }, loadQueue));
+
+    // Each convolution filters a single channel
+    auto channelSpec = spec;
+    channelSpec.numChannels = 1;
+
+    for (auto* convolution : convolutions)
+        convolution->prepare(channelSpec);
+
+    modeFadeStep = 1.f / (float) juce::jmax(1, juce::roundToInt(spec.sampleRate * modeFadeTimeSeconds));
+}
+
+void LinearPhaseFilter::reset()
+{
+    for (auto* convolution : convolutions)
+        convolution->reset();
+
+    // Nothing is left of the old tail, so the encoding can jump straight to the kernels
+    if (const auto kernelsMidSide = getKernelsMidSide())
+    {
+        midSideEncoding = *kernelsMidSide;
+        modeFadeGain = modeFadeTarget = 1.f;
+    }
+}
+
+void LinearPhaseFilter::requestKernel(const StereoChainCoefficients& coefficients, double sampleRate, int order)
+{
+    {
+        const juce::ScopedLock sl(requestLock);
+        requestedCoefficients = coefficients;
+        requestedSampleRate = sampleRate;
+        requestedOrder = juce::jlimit(MinOrder, MaxOrder, order);
+        kernelRequested = true;
+    }
+
+    notify();
+}
+
+void LinearPhaseFilter::process(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numChannels = juce::jmin(block.getNumChannels(), (size_t) convolutions.size());
+    const auto numSamples = (int) block.getNumSamples();
+
+    // The convolutions swap kernels in their own time, so the encoding waits
+    // until both have the new mode's, then fades out, switches and clears the
+    // old tail, and fades back in
+    if (numChannels >= 2)
+    {
+        const auto kernelsMidSide = getKernelsMidSide();
+
+        if (modeFadeTarget == 0.f && modeFadeGain == 0.f && kernelsMidSide.has_value())
+        {
+            midSideEncoding = *kernelsMidSide;
+            convolutions[0]->reset();
+            convolutions[1]->reset();
+            modeFadeTarget = 1.f;
+        }
+        else if (kernelsMidSide.has_value())
+        {
+            modeFadeTarget = *kernelsMidSide != midSideEncoding ? 0.f : 1.f;
+        }
+    }
+
+    const auto midSideChannels = midSideEncoding && numChannels >= 2;
+
+    // Mid and side at half the level, so decoding is a plain sum and difference
+    auto* first = block.getChannelPointer(0);
+    auto* second = numChannels >= 2 ? block.getChannelPointer(1) : nullptr;
+
+    if (midSideChannels)
+    {
+        juce::FloatVectorOperations::add(first, second, numSamples);
+        juce::FloatVectorOperations::multiply(first, 0.5f, numSamples);
+        juce::FloatVectorOperations::subtract(second, first, numSamples);
+        juce::FloatVectorOperations::negate(second, second, numSamples);
+    }
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto channelBlock = block.getSingleChannelBlock(channel);
+        juce::dsp::ProcessContextReplacing<float> context(channelBlock);
+        convolutions[(int) channel]->process(context);
+    }
+
+    if (midSideChannels)
+    {
+        juce::FloatVectorOperations::add(first, second, numSamples);
+        juce::FloatVectorOperations::multiply(second, -2.0f, numSamples);
+        juce::FloatVectorOperations::add(second, first, numSamples);
+    }
+
+    if (numChannels >= 2 && (modeFadeGain < 1.f || modeFadeTarget < 1.f))
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            modeFadeGain = modeFadeTarget > modeFadeGain ? juce::jmin(modeFadeTarget, modeFadeGain + modeFadeStep)
+                                                         : juce::jmax(modeFadeTarget, modeFadeGain - modeFadeStep);
+            first[i] *= modeFadeGain;
+            second[i] *= modeFadeGain;
+        }
+    }
+}
+
+std::optional<bool> LinearPhaseFilter::getKernelsMidSide() const
+{
+    if (convolutions.size() < 2)
+        return {};
+
+    const auto firstSize = convolutions[0]->getCurrentIRSize();
+    const auto secondSize = convolutions[1]->getCurrentIRSize();
+
+    if (firstSize == 0 || secondSize == 0 || firstSize % 2 != secondSize % 2)
+        return {};
+
+    return firstSize % 2 == 0;
+}
+
+//==============================================================================
+void LinearPhaseFilter::run()
+{
+    while (! threadShouldExit())
+    {
+        StereoChainCoefficients coefficients;
+        double sampleRate = 0;
+        int order = MinOrder;
+        bool requested;
+
+        {
+            const juce::ScopedLock sl(requestLock);
+            requested = std::exchange(kernelRequested, false);
+            coefficients = requestedCoefficients;
+            sampleRate = requestedSampleRate;
+            order = requestedOrder;
+        }
+
+        // A request made since the check has already signalled, so this returns at once
+        if (! requested)
+        {
+            wait(-1);
+            continue;
+        }
+
+        // Linked channels share one design
+        std::array<juce::AudioBuffer<float>, NumChannelSets> kernels;
+        kernels[0] = designKernel(coefficients.channelSets[0], sampleRate, order);
+        kernels[1] = coefficients.mode == StereoMode::stereo ? kernels[0]
+                                                             : designKernel(coefficients.channelSets[1], sampleRate, order);
+
+        // Mid/side kernels get a trailing zero tap. The even length tells process()
+        // which encoding a convolution's current kernel expects.
+        if (coefficients.mode == StereoMode::midSide)
+            for (auto& kernel : kernels)
+                kernel.setSize(1, kernel.getNumSamples() + 1, true, true);
+
+        // The convolutions take ownership, so each gets a copy
+        const juce::ScopedLock sl(convolutionLock);
+
+        for (int channel = 0; channel < convolutions.size(); ++channel)
+        {
+            auto* convolution = convolutions[channel];
+            juce::AudioBuffer<float> copy(kernels[(size_t) getChannelSet((size_t) channel)]);
+            convolution->loadImpulseResponse(std::move(copy), sampleRate,
+                                             juce::dsp::Convolution::Stereo::no,
+                                             juce::dsp::Convolution::Trim::no,
+                                             juce::dsp::Convolution::Normalise::no);
+        }
+    }
+}
+
+juce::AudioBuffer<float> LinearPhaseFilter::designKernel(const ChainCoefficients& coefficients, double sampleRate, int order)
+{
+    const auto size = 1 << order;
+    const auto numTaps = size - 1;
+    const auto centre = size / 2 - 1;
+
+    // Real magnitudes, zero phase, for bins 0 to size / 2
+    std::vector<float> spectrum((size_t) size * 2, 0.f);
+
+    for (int bin = 0; bin <= size / 2; ++bin)
+    {
+        const auto frequency = (double) bin * sampleRate / (double) size;
+        spectrum[(size_t) bin * 2] = (float) getMagnitudeForFrequency(coefficients, frequency);
+    }
+
+    juce::dsp::FFT(order).performRealOnlyInverseTransform(spectrum.data());
+
+    // The zero phase impulse wraps around index 0; unwrap it around the centre
+    // tap and window it to the kernel length
+    std::vector<float> window((size_t) numTaps);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) numTaps,
+                                                             juce::dsp::WindowingFunction<float>::blackman, false);
+
+    juce::AudioBuffer<float> kernel(1, numTaps);
+    auto* taps = kernel.getWritePointer(0);
+
+    for (int i = 0; i < numTaps; ++i)
+        taps[i] = spectrum[(size_t) ((i - centre + size) % size)] * window[(size_t) i];
+
+    return kernel;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <optional>
+
+#include "CoefficientDesigner.h"
+
+/*  Linear phase version of the cascade. The magnitude response of the designed
+    chain is sampled on an FFT grid, transformed to a zero phase impulse,
+    windowed and shifted into a symmetric FIR, which then runs through one
+    uniformly partitioned juce::dsp::Convolution per channel.
+
+    Kernels are built on a thread of their own and handed to the convolutions,
+    which load them in the background and crossfade to them, so processing
+    never allocates or waits. The FIR delays everything by getLatencyInSamples().
+
+    Channel 1 gets the second channel set's kernel. In mid/side mode the first
+    two channels are encoded around the convolutions, switching only once
+    both convolutions have picked up kernels for the new mode.
+*/
+class LinearPhaseFilter : private juce::Thread
+{
+public:
+    // FFT orders of the selectable FIR lengths, 4096 to 32768 taps. Longer
+    // kernels resolve low frequencies better at the cost of latency.
+    static constexpr int MinOrder = 12;
+    static constexpr int MaxOrder = 15;
+
+    LinearPhaseFilter();
+    ~LinearPhaseFilter() override;
+
+    // Not realtime safe. Kernels already loaded are kept.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // Asks for a kernel matching coefficients at sampleRate, 2^order long. The
+    // coefficients may be designed for a higher rate. Returns straight away;
+    // only the newest request is built. Never call from the audio thread.
+    void requestKernel(const StereoChainCoefficients& coefficients, double sampleRate, int order);
+
+    // Half the kernel, which is the delay of a symmetric FIR
+    static int getLatencyInSamples(int order) { return (1 << order) / 2 - 1; }
+
+    // Filters up to the number of channels prepared for, in place
+    void process(const juce::dsp::AudioBlock<float>& block);
+private:
+    // Loads kernels for every convolution off its own thread
+    juce::dsp::ConvolutionMessageQueue loadQueue;
+
+    // Guards convolutions against prepare() while a kernel is being handed over
+    juce::CriticalSection convolutionLock;
+    juce::OwnedArray<juce::dsp::Convolution> convolutions;
+
+    // Audio thread only: the encoding around the first two convolutions, and
+    // the fade that hides switching it
+    static constexpr double modeFadeTimeSeconds = 0.01;
+    bool midSideEncoding = false;
+    float modeFadeGain = 1.f;
+    float modeFadeTarget = 1.f;
+    float modeFadeStep = 1.f;
+
+    juce::CriticalSection requestLock;
+    StereoChainCoefficients requestedCoefficients;
+    double requestedSampleRate = 0;
+    int requestedOrder = MinOrder;
+    bool kernelRequested = false;
+
+    // Whether the first two convolutions are running mid/side kernels, or
+    // nothing while they disagree or have none yet
+    std::optional<bool> getKernelsMidSide() const;
+
+    void run() override;
+    static juce::AudioBuffer<float> designKernel(const ChainCoefficients& coefficients, double sampleRate, int order);
+};
@@ -208,8 +208,7 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 //======================================================================
 ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor& p) :
     processorRef(p),
-    leftPathProducer(p.leftChannelFifo),
-    rightPathProducer(p.rightChannelFifo)
+    pathProducer(p.leftChannelFifo, p.rightChannelFifo)
 {
     const auto& params = processorRef.getParameters();
     for ( auto param : params )
@@ -219,6 +218,8 @@ ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor& p) :
 
     updateChain();
 
+    analyzerThread->addProducer(&pathProducer);
+
     startTimerHz(60);
 
     setSize (600, 480);
@@ -226,6 +227,8 @@ ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor& p) :
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    analyzerThread->removeProducer(&pathProducer);
+
     const auto& params = processorRef.getParameters();
     for ( auto param : params )
     {
@@ -238,65 +241,219 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
     parametersChanged.set(true);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+void PathProducer::setSettings(const AnalyzerSettings& newSettings)
+{
+    publishedSettings.getWriteSlot() = newSettings;
+    publishedSettings.publish();
+}
+
+juce::Path PathProducer::getPath(Channel channel)
+{
+    // The slot stays ours until the next acquire, so it can be kept between calls
+    if (auto* path = publishedPaths[channel].acquire())
+    {
+        latestPaths[channel] = path;
+        ++numPathsDisplayed;
+    }
+
+    return latestPaths[channel] != nullptr ? *latestPaths[channel] : juce::Path();
+}
+
+int PathProducer::getHopSize() const
 {
+    const auto overlap = juce::jlimit(0.f, 0.99f, settings.overlap);
+    return juce::jmax(1, juce::roundToInt((float) stereoFFTDataGenerator.getFFTSize() * (1.f - overlap)));
+}
+
+void PathProducer::process()
+{
+    if (auto* newSettings = publishedSettings.acquire())
+    {
+        settings = *newSettings;
+
+        // Nothing is queued between polls, so this can switch straight over.
+        // The window holds enough history to redraw at the new resolution at once.
+        if (settings.order != stereoFFTDataGenerator.getOrder()
+            || settings.window != stereoFFTDataGenerator.getWindow())
+        {
+            stereoFFTDataGenerator.changeWindow(settings.window);
+            stereoFFTDataGenerator.changeOrder(settings.order);
+            samplesSinceLastFFT = getHopSize();
+        }
+    }
+
+    // Nothing to draw into yet
+    if (settings.sampleRate <= 0 || settings.fftBounds.isEmpty())
+        return;
+
+    auto& leftFifo = *channelFifos[Channel::Left];
+    auto& rightFifo = *channelFifos[Channel::Right];
     juce::AudioBuffer<float> tempIncomingBuffer;
-    while( singleChannelFifo->getNumCompleteBuffersAvailable() > 0)
+
+    // The processor feeds both FIFOs the same blocks, so they're taken in
+    // pairs and share a write position
+    while( leftFifo.getNumCompleteBuffersAvailable() > 0 && rightFifo.getNumCompleteBuffersAvailable() > 0 )
     {
-        if( singleChannelFifo->getAudioBuffer(tempIncomingBuffer) )
+        const auto windowSize = stereoBuffer.getNumSamples();
+        int size = 0;
+
+        for (auto channel : { Channel::Left, Channel::Right })
         {
-            auto size = tempIncomingBuffer.getNumSamples();
-            // Shift data forward by buffer size.
-            // Remove `size` number of samples from the left hand side
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                                              monoBuffer.getReadPointer(0, size),
-                                              monoBuffer.getNumSamples() - size);
-
-            // Copy size number of samples from the incoming buffer to the end (Right hand side) of the monoBuffer
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                              tempIncomingBuffer.getReadPointer(0, 0),
-                                              size);
-
-            singleChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+            if( ! channelFifos[channel]->getAudioBuffer(tempIncomingBuffer) )
+                continue;
+
+            auto* incoming = tempIncomingBuffer.getReadPointer(0);
+            size = tempIncomingBuffer.getNumSamples();
+
+            // Only the newest windowSize samples of a longer block make it into the window
+            if (size > windowSize)
+            {
+                incoming += size - windowSize;
+                size = windowSize;
+            }
+
+            // Overwrite the oldest samples, wrapping around at the end
+            const auto numToEnd = juce::jmin(size, windowSize - writePosition);
+            juce::FloatVectorOperations::copy(stereoBuffer.getWritePointer(channel, writePosition), incoming, numToEnd);
+            juce::FloatVectorOperations::copy(stereoBuffer.getWritePointer(channel), incoming + numToEnd, size - numToEnd);
         }
+
+        writePosition = (writePosition + size) % windowSize;
+        samplesSinceLastFFT += size;
+    }
+
+    // One FFT per hop at most, and only of the newest window: only the last
+    // path of each poll is ever drawn, so hops that went by since are skipped
+    if (samplesSinceLastFFT >= getHopSize())
+    {
+        stereoFFTDataGenerator.produceFFTDataForRendering(stereoBuffer, writePosition, -48.f);
+        samplesSinceLastFFT = 0;
+        ++numFFTsComputed;
     }
 
     /* If there are fftData buffers to pull
             If we can pull a buffer
                 Produce a path
      */
-    // const auto fftBounds = getAnalysisArea().toFloat();
-    const auto fftSize = singleChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = sampleRate / (double)fftSize;
+    const auto fftSize = stereoFFTDataGenerator.getFFTSize();
+    const auto binWidth = settings.sampleRate / (double)fftSize;
 
-    while( singleChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0 )
+    for (auto channel : { Channel::Left, Channel::Right })
     {
-        std::vector<float> fftData;
-        if( singleChannelFFTDataGenerator.getFFTData(fftData))
+        auto& pathGenerator = pathGenerators[channel];
+        bool produced = false;
+
+        while( stereoFFTDataGenerator.getNumAvailableFFTDataBlocks(channel) > 0 )
+        {
+            // renderData has room for the largest order, so this never reallocates
+            if( stereoFFTDataGenerator.getFFTData(channel, renderData))
+            {
+                pathGenerator.generatePath(renderData, settings.fftBounds, fftSize, binWidth, -48.f);
+            }
+        }
+
+        /* While there are paths to be pulled
+            Pull as many as possible
+                Only display most recent
+         */
+        while(pathGenerator.getNumPathsAvailable() > 0)
         {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+            produced = pathGenerator.getPath(channelPaths[channel]) || produced;
+        }
+
+        if (produced)
+        {
+            publishedPaths[channel].getWriteSlot() = channelPaths[channel];
+            publishedPaths[channel].publish();
         }
     }
+}
 
-    /* While there are paths to be pulled
-        Pull as many as possible
-            Only display most recent
-     */
-    while(pathProducer.getNumPathsAvailable() > 0)
+//======================================================================
+AnalyzerThread::AnalyzerThread() : juce::Thread("EQ analyzer")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+AnalyzerThread::~AnalyzerThread()
+{
+    stopThread(1000);
+}
+
+void AnalyzerThread::addProducer(PathProducer* producer)
+{
+    const juce::ScopedLock sl(producerLock);
+    producers.addIfNotAlreadyThere(producer);
+}
+
+void AnalyzerThread::removeProducer(PathProducer* producer)
+{
+    const juce::ScopedLock sl(producerLock);
+    producers.removeFirstMatchingValue(producer);
+}
+
+void AnalyzerThread::run()
+{
+    while (! threadShouldExit())
     {
-        pathProducer.getPath(singleChannelFFTPath);
+        {
+            const juce::ScopedLock sl(producerLock);
+            for (auto* producer : producers)
+                producer->process();
+        }
+
+        wait(pollIntervalMs);
     }
 }
 
-void ResponseCurveComponent::timerCallback()
+//======================================================================
+void ResponseCurveComponent::toggleAnalysisBypass(bool bypassed)
 {
+    if (bypassed == showFFTAnalysis)
+        return;
+
+    showFFTAnalysis = bypassed;
+
     if (showFFTAnalysis)
     {
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = processorRef.getSampleRate();
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+        analyzerThread->addProducer(&pathProducer);
     }
+    else
+    {
+        analyzerThread->removeProducer(&pathProducer);
+    }
+}
+
+void ResponseCurveComponent::timerCallback()
+{
+    // The analyzer thread does the work; this only hands over where to draw
+    // In the order of the "Analyser Window" choices
+    using Window = juce::dsp::WindowingFunction<float>;
+    static constexpr std::array<Window::WindowingMethod, 5> windows { Window::blackmanHarris, Window::hann, Window::hamming,
+                                                                      Window::blackman, Window::flatTop };
+
+    // In the order of the "Analyser Overlap" choices
+    static constexpr std::array<float, 4> overlaps { 0.f, 0.25f, 0.5f, 0.75f };
+
+    auto getChoice = [this](const char* parameterID)
+    {
+        return (int) processorRef.apvts.getRawParameterValue(parameterID)->load();
+    };
+
+    AnalyzerSettings newSettings;
+    newSettings.fftBounds = getAnalysisArea().toFloat();
+    newSettings.sampleRate = processorRef.getSampleRate();
+    newSettings.overlap = overlaps[(size_t) juce::jlimit(0, (int) overlaps.size() - 1, getChoice("Analyser Overlap"))];
+    newSettings.order = static_cast<FFTOrder>(minFFTOrder + getChoice("Analyser Resolution"));
+    newSettings.window = windows[(size_t) juce::jlimit(0, (int) windows.size() - 1, getChoice("Analyser Window"))];
+
+    if (newSettings != analyzerSettings)
+    {
+        analyzerSettings = newSettings;
+        pathProducer.setSettings(analyzerSettings);
+    }
+
+    showAnalyzerStats = getChoice("Analyser Stats") != 0;
 
     if( parametersChanged.compareAndSetBool(false, true) )
     {
@@ -328,6 +485,15 @@ void ResponseCurveComponent::updateChain()
     auto highCutCoefficients = makeHighCutFilter(chainSettings, processorRef.getSampleRate());
     updateCutFilter(monoChain.get<ChainPositions::HighCut>(),
                     highCutCoefficients, chainSettings.highCutSlope);
+
+    for (size_t i = 0; i < extraPeaks.size(); ++i)
+    {
+        const auto& band = chainSettings.extraPeaks[i];
+        extraPeakActive[i] = ! band.bypassed;
+
+        if (extraPeakActive[i])
+            designPeakBandInDoublePrecision(band, processorRef.getSampleRate(), extraPeaks[i]);
+    }
 }
 
 void ResponseCurveComponent::paint (juce::Graphics& g)
@@ -359,6 +525,10 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
         if (! monoChain.isBypassed<ChainPositions::Peak>() )
             mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
 
+        for (size_t band = 0; band < extraPeaks.size(); ++band)
+            if (extraPeakActive[band])
+                mag *= getMagnitudeForFrequency(extraPeaks[band], freq, sampleRate);
+
         if (!monoChain.isBypassed<ChainPositions::LowCut>() )
         {
             if (!lowCut.isBypassed<0>() )
@@ -403,17 +573,29 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
 
     if (showFFTAnalysis)
     {
-        auto leftChannelFFTPath = leftPathProducer.getPath();
+        auto leftChannelFFTPath = pathProducer.getPath(Channel::Left);
         leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY() ));
 
         g.setColour(Colours::skyblue);
         g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
 
-        auto rightChannelFFTPath = rightPathProducer.getPath();
+        auto rightChannelFFTPath = pathProducer.getPath(Channel::Right);
         rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY() ));
 
         g.setColour(Colours::lightyellow);
         g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+
+        if (showAnalyzerStats)
+        {
+            // Stereo FFTs run against paths drawn, both channels together
+            const auto numFFTs = pathProducer.getNumFFTsComputed();
+            const auto numPaths = pathProducer.getNumPathsDisplayed();
+
+            g.setColour(Colours::lightgrey);
+            g.setFont(10);
+            g.drawText("FFTs " + String(numFFTs) + " / frames " + String(numPaths),
+                       responseArea.withHeight(12).reduced(4, 0), Justification::centredRight);
+        }
     }
 
     g.setColour(Colours::orange);
@@ -572,7 +754,14 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
       lowCutBypassButtonAttachment(p.apvts, "LowCut Bypassed", lowCutBypassButton),
       highCutBypassButtonAttachment(p.apvts, "HighCut Bypassed", highCutBypassButton),
       peakBypassButtonAttachment(p.apvts, "Peak Bypassed", peakBypassButton),
-      analyserBypassButtonAttachment(p.apvts, "Analyser Bypassed", analyserBypassButton)
+      analyserBypassButtonAttachment(p.apvts, "Analyser Bypassed", analyserBypassButton),
+      analyserResolutionBox(*p.apvts.getParameter("Analyser Resolution")),
+      analyserWindowBox(*p.apvts.getParameter("Analyser Window")),
+      analyserOverlapBox(*p.apvts.getParameter("Analyser Overlap")),
+      analyserStatsButtonAttachment(p.apvts, "Analyser Stats", analyserStatsButton),
+      analyserResolutionBoxAttachment(p.apvts, "Analyser Resolution", analyserResolutionBox),
+      analyserWindowBoxAttachment(p.apvts, "Analyser Window", analyserWindowBox),
+      analyserOverlapBoxAttachment(p.apvts, "Analyser Overlap", analyserOverlapBox)
 {
       // Add labels for max and min values
       peakFreqSlider.labels.add({0.f, "20Hz"});
@@ -681,6 +870,12 @@ void AudioPluginAudioProcessorEditor::resized()
 
     analyserBypassButton.setBounds(analyserEnabledArea);
 
+    auto analyserSettingsArea = analyserEnabledArea.withX(analyserEnabledArea.getRight() + 5);
+    analyserResolutionBox.setBounds(analyserSettingsArea);
+    analyserWindowBox.setBounds(analyserSettingsArea.withX(analyserSettingsArea.getRight() + 5).withWidth(130));
+    analyserOverlapBox.setBounds(analyserWindowBox.getBounds().withX(analyserWindowBox.getRight() + 5).withWidth(80));
+    analyserStatsButton.setBounds(analyserOverlapBox.getBounds().withX(analyserOverlapBox.getRight() + 5).withWidth(70));
+
     bounds.removeFromTop(5);
 
     float hRatio = 33 / 100.f;
@@ -722,6 +917,10 @@ std::vector<juce::Component*> AudioPluginAudioProcessorEditor::getComps()
         &lowCutBypassButton,
         &highCutBypassButton,
         &peakBypassButton,
-        &analyserBypassButton
+        &analyserBypassButton,
+        &analyserResolutionBox,
+        &analyserWindowBox,
+        &analyserOverlapBox,
+        &analyserStatsButton
     };
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "SIMDKernels.h"
 
 #define JUCE_LIVE_CONSTANT
 
@@ -11,71 +12,142 @@ enum FFTOrder
     order8192 = 13
 };
 
+// The analyser resolutions, in the order of the "Analyser Resolution" choices
+constexpr FFTOrder minFFTOrder = order2048;
+constexpr FFTOrder maxFFTOrder = order8192;
+
+/*  Analyses the left and right channels with a single complex FFT: left goes
+    in the real part and right in the imaginary part, and since both are
+    real their spectra can be separated again afterwards (see
+    SIMDKernels::RealPairDecibelKernel). That takes one pass over the bins,
+    which also converts both to decibels.
+*/
 template <typename BlockType>
 struct FFTDataGenerator
 {
-    // Produces FFT data from a sample buffer
-    void produceFFTDataForRendering(const juce::AudioBuffer<float> &audioData, const float negativeInfinity)
-    {
-        const auto fftSize = getFFTSize();
-
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+    using WindowingFunction = juce::dsp::WindowingFunction<float>;
 
-        // First apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);     // [1]
+    // Allocates a transform and a window table for every order up front, and
+    // the rest for the largest, so changeOrder() and changeWindow() never
+    // allocate afterwards
+    FFTDataGenerator()
+    {
+        for (int i = minFFTOrder; i <= maxFFTOrder; ++i)
+        {
+            forwardFFTs[(size_t) (i - minFFTOrder)] = std::make_unique<juce::dsp::FFT>(i);
+            windowTables[(size_t) (i - minFFTOrder)].resize((size_t) 1 << i);
+        }
 
-        // Render our FFT data
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data()); // [2]
+        fillWindowTables();
 
-        int numBins = (int)fftSize / 2;
+        const auto maxFFTSize = (size_t) 1 << maxFFTOrder;
+        packedInput.resize(maxFFTSize);
+        packedSpectrum.resize(maxFFTSize);
 
-        // Normalise the FFT values
-        for (int i = 0; i < numBins; ++i)
+        for (size_t channel = 0; channel < fftData.size(); ++channel)
         {
-            fftData[i] /= (float) numBins;
+            fftData[channel].resize(maxFFTSize, 0);
+            fftDataFifos[channel].prepare(fftData[channel].size());
         }
 
-        // Convert to decibels
-        for(int i = 0; i < numBins; ++i)
+        changeOrder(minFFTOrder);
+    }
+
+    // Produces FFT data for both channels from the newest getFFTSize() samples
+    // of a circular buffer, indexed by Channel, the oldest of all of them being
+    // at oldestSample
+    void produceFFTDataForRendering(const juce::AudioBuffer<float> &audioData, int oldestSample, const float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+        const auto bufferSize = audioData.getNumSamples();
+        jassert(fftSize <= bufferSize && audioData.getNumChannels() >= 2);
+
+        // Gather each window in order, unwrapping it at the end of the buffer
+        const auto start = (oldestSample + bufferSize - fftSize) % bufferSize;
+        const auto numToEnd = juce::jmin(fftSize, bufferSize - start);
+
+        for (size_t channel = 0; channel < fftData.size(); ++channel)
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            auto* readIndex = audioData.getReadPointer((int) channel);
+            auto& data = fftData[channel];
+            std::copy(readIndex + start, readIndex + start + numToEnd, data.begin());
+            std::copy(readIndex, readIndex + fftSize - numToEnd, data.begin() + numToEnd);
+
+            // First apply a windowing function to our data
+            juce::FloatVectorOperations::multiply(data.data(), getWindowTable().data(), fftSize);     // [1]
         }
 
-        fftDataFifo.push(fftData);
+        // Pack left + i * right and transform both at once
+        const auto& left = fftData[Channel::Left];
+        const auto& right = fftData[Channel::Right];
+
+        for (int i = 0; i < fftSize; ++i)
+            packedInput[(size_t) i] = { left[(size_t) i], right[(size_t) i] };
+
+        forwardFFT->perform(packedInput.data(), packedSpectrum.data(), false);      // [2]
+
+        int numBins = (int)fftSize / 2;
+
+        // Separate, normalise and convert both spectra to decibels in one vectorised pass
+        SIMDKernels::getWidestKernelSet().realPairToDecibels(reinterpret_cast<const float*>(packedSpectrum.data()), fftSize,
+                                                             fftData[Channel::Left].data(), fftData[Channel::Right].data(),
+                                                             numBins, 1.f / (float) numBins, negativeInfinity);
+
+        for (size_t channel = 0; channel < fftData.size(); ++channel)
+            fftDataFifos[channel].push(fftData[channel]);
     }
 
+    // Every order has its own transform and window table, and the buffers are
+    // sized for maxFFTOrder, so this only picks them. FFT data already queued
+    // is for the old order, so drain it first.
     void changeOrder(FFTOrder newOrder)
     {
-        // When you change order, recreate the window, forwardFFT, fifo, fftData
-        // Also reset the fifo index
-        // Things that need recreating should be created in the heap via std::make_unique<>
-        order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        order = juce::jlimit(minFFTOrder, maxFFTOrder, newOrder);
+        forwardFFT = forwardFFTs[(size_t) (order - minFFTOrder)].get();
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
+        // Within the capacity reserved for maxFFTOrder
+        for (auto& data : fftData)
+            data.resize((size_t) getFFTSize(), 0);
+    }
 
-        fftDataFifo.prepare(fftData.size());
+    // Rewrites every order's table in place
+    void changeWindow(WindowingFunction::WindowingMethod newMethod)
+    {
+        windowingMethod = newMethod;
+        fillWindowTables();
     }
+
+    FFTOrder getOrder() const { return order; }
+    WindowingFunction::WindowingMethod getWindow() const { return windowingMethod; }
     //==================================================================
     int getFFTSize() const { return 1 << order; }
-    // See how much FFT data is available
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
+    // See how much FFT data is available for a channel
+    int getNumAvailableFFTDataBlocks(Channel channel) const { return fftDataFifos[channel].getNumAvailableForReading(); }
     //==================================================================
-    // Return FFT data to the fftData buffer
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    // Return a channel's FFT data to the fftData buffer
+    bool getFFTData(Channel channel, BlockType& fftData) { return fftDataFifos[channel].pull(fftData); }
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    FFTOrder order = minFFTOrder;
+    WindowingFunction::WindowingMethod windowingMethod = WindowingFunction::blackmanHarris;
+    std::array<std::unique_ptr<juce::dsp::FFT>, maxFFTOrder - minFFTOrder + 1> forwardFFTs;
+    juce::dsp::FFT* forwardFFT = nullptr;
+
+    // One per order, each exactly that order's size
+    std::array<std::vector<float>, maxFFTOrder - minFFTOrder + 1> windowTables;
+
+    const std::vector<float>& getWindowTable() const { return windowTables[(size_t) (order - minFFTOrder)]; }
+
+    void fillWindowTables()
+    {
+        for (auto& table : windowTables)
+            WindowingFunction::fillWindowingTables(table.data(), table.size(), windowingMethod, true);
+    }
+
+    // Indexed by Channel: the windowed input, then the decibels
+    std::array<BlockType, 2> fftData;
+    std::vector<juce::dsp::Complex<float>> packedInput, packedSpectrum;
 
-    Fifo<BlockType> fftDataFifo;
+    std::array<Fifo<BlockType>, 2> fftDataFifos;
 };
 
 template<typename PathType>
@@ -194,27 +266,105 @@ private:
     juce::String suffix;
 };
 
+// Where and at what rate the spectrum is drawn
+struct AnalyzerSettings
+{
+    juce::Rectangle<float> fftBounds;
+    double sampleRate = 0;
+
+    // How much each FFT window overlaps the previous one, from 0 up to just
+    // under 1. Sets the hop between windows, whatever the host block size.
+    float overlap = 0.5f;
+
+    FFTOrder order = minFFTOrder;
+    juce::dsp::WindowingFunction<float>::WindowingMethod window = juce::dsp::WindowingFunction<float>::blackmanHarris;
+
+    bool operator==(const AnalyzerSettings& other) const
+    {
+        return fftBounds == other.fftBounds && sampleRate == other.sampleRate && overlap == other.overlap
+            && order == other.order && window == other.window;
+    }
+    bool operator!=(const AnalyzerSettings& other) const { return ! operator==(other); }
+};
+
+// Both channels' analyzer paths, from one FFT per window
 struct PathProducer
 {
-    PathProducer(SingleChannelSampleFifo<AudioPluginAudioProcessor::BlockType>& scsf) :
-        singleChannelFifo(&scsf)
+    using SampleFifo = SingleChannelSampleFifo<AudioPluginAudioProcessor::BlockType>;
+
+    PathProducer(SampleFifo& leftFifo, SampleFifo& rightFifo)
         {
             /* If sample rate = 48000 and order = 2048 bins:
             * 48000 / 2048 = 23Hz of resolution
+            * The window keeps enough history for the largest order, so
+            * switching order can analyse straight away.
             */
-            singleChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-            monoBuffer.setSize(1, singleChannelFFTDataGenerator.getFFTSize());
+            channelFifos[Channel::Left] = &leftFifo;
+            channelFifos[Channel::Right] = &rightFifo;
+            stereoBuffer.setSize(2, 1 << maxFFTOrder);
         }
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return singleChannelFFTPath; }
+
+    // Message thread: settings for the paths produced from now on
+    void setSettings(const AnalyzerSettings& settings);
+
+    // Analyzer thread: pulls whatever audio arrived and publishes new paths for it
+    void process();
+
+    // Message thread: the newest path published for a channel, ready to draw
+    juce::Path getPath(Channel channel);
+
+    // Samples between the starts of consecutive FFT windows
+    int getHopSize() const;
+
+    // FFTs run so far, against the new paths picked up by getPath(). Each
+    // FFT analyses both channels.
+    juce::uint32 getNumFFTsComputed() const { return numFFTsComputed.load(); }
+    juce::uint32 getNumPathsDisplayed() const { return numPathsDisplayed; }
+private:
+    std::array<SampleFifo*, 2> channelFifos;    // Indexed by Channel, like the rest
+
+    // The newest samples of each channel, enough for maxFFTOrder, written
+    // around in a circle; the oldest of them is at writePosition
+    juce::AudioBuffer<float> stereoBuffer;
+    int writePosition = 0;
+    int samplesSinceLastFFT = 0;
+    FFTDataGenerator<std::vector<float>> stereoFFTDataGenerator;
+    std::array<AnalyzerPathGenerator<juce::Path>, 2> pathGenerators;
+    std::array<juce::Path, 2> channelPaths;
+    std::vector<float> renderData = std::vector<float>((size_t) 1 << maxFFTOrder);
+
+    // Mailboxes between the two threads, so neither ever waits on the other
+    TripleBuffer<AnalyzerSettings> publishedSettings;
+    std::array<TripleBuffer<juce::Path>, 2> publishedPaths;
+    AnalyzerSettings settings;                                  // Analyzer side
+    std::array<const juce::Path*, 2> latestPaths { nullptr, nullptr };   // Message side
+
+    std::atomic<juce::uint32> numFFTsComputed { 0 };
+    juce::uint32 numPathsDisplayed = 0;
+};
+
+//======================================================================
+/*  One analyzer thread shared by every editor in the process. The FFTs and
+    path building for every open analyzer run here at the display rate, so
+    the message thread only draws the finished paths.
+*/
+class AnalyzerThread : private juce::Thread
+{
+public:
+    AnalyzerThread();
+    ~AnalyzerThread() override;
+
+    void addProducer(PathProducer* producer);
+
+    // Once this returns the producer is guaranteed not to be in process()
+    void removeProducer(PathProducer* producer);
 private:
-    SingleChannelSampleFifo<AudioPluginAudioProcessor::BlockType>* singleChannelFifo;
+    static constexpr int pollIntervalMs = 1000 / 60;
 
-    juce::AudioBuffer<float> monoBuffer;
-    FFTDataGenerator<std::vector<float>> singleChannelFFTDataGenerator;
-    AnalyzerPathGenerator<juce::Path> pathProducer;
-    juce::Path singleChannelFFTPath;
+    juce::CriticalSection producerLock;
+    juce::Array<PathProducer*> producers;
 
+    void run() override;
 };
 
 struct ResponseCurveComponent : juce::Component,
@@ -246,15 +396,17 @@ struct ResponseCurveComponent : juce::Component,
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    void toggleAnalysisBypass(bool bypassed)
-    {
-        showFFTAnalysis = bypassed;
-    }
+    // Hidden analyzers are taken off the analyzer thread
+    void toggleAnalysisBypass(bool bypassed);
     private:
         AudioPluginAudioProcessor& processorRef;
         juce::Atomic<bool> parametersChanged { false };
         MonoChain monoChain;
 
+        // The bands after "Peak", which MonoChain has no room for
+        std::array<BiquadCoefficients, ChainCoefficients::MaxPeakBands - 1> extraPeaks;
+        std::array<bool, ChainCoefficients::MaxPeakBands - 1> extraPeakActive {};
+
         void updateChain();
 
         juce::Image background;
@@ -263,11 +415,24 @@ struct ResponseCurveComponent : juce::Component,
 
         juce::Rectangle<int> getAnalysisArea();
 
-        PathProducer leftPathProducer, rightPathProducer;
+        PathProducer pathProducer;
+        juce::SharedResourcePointer<AnalyzerThread> analyzerThread;
+        AnalyzerSettings analyzerSettings;  // As last handed to the producers
+        bool showAnalyzerStats = false;     // "Analyser Stats"
 
         bool showFFTAnalysis = true;
 };
 
+// Lists the choices of an AudioParameterChoice, for a ComboBoxAttachment to pick from
+struct ChoiceBox : juce::ComboBox
+{
+    ChoiceBox(juce::RangedAudioParameter& rap)
+    {
+        if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(&rap))
+            addItemList(choiceParam->choices, 1);
+    }
+};
+
 struct PowerButton : juce::ToggleButton { };
 struct AnalyserButton : juce::ToggleButton
 {
@@ -332,12 +497,20 @@ private:
 
     PowerButton lowCutBypassButton, highCutBypassButton, peakBypassButton;
     AnalyserButton analyserBypassButton;
+    ChoiceBox analyserResolutionBox, analyserWindowBox, analyserOverlapBox;
+    juce::ToggleButton analyserStatsButton { "Stats" };
 
     using ButtonAttachment = APVTS::ButtonAttachment;
     ButtonAttachment lowCutBypassButtonAttachment,
                      highCutBypassButtonAttachment,
                      peakBypassButtonAttachment,
-                     analyserBypassButtonAttachment;
+                     analyserBypassButtonAttachment,
+                     analyserStatsButtonAttachment;
+
+    using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+    ComboBoxAttachment analyserResolutionBoxAttachment,
+                       analyserWindowBoxAttachment,
+                       analyserOverlapBoxAttachment;
 
     LookAndFeel lnf;
 
@@ -12,10 +12,21 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
                      #endif
                        )
 {
+    for (auto* param : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.addParameterListener(withID->paramID, this);
+
+    designerThread->addClient(this);
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
+    cancelPendingUpdate();
+    designerThread->removeClient(this);
+
+    for (auto* param : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.removeParameterListener(withID->paramID, this);
 }
 
 //==============================================================================
@@ -36,63 +47,266 @@ Coefficients makePeakFilter(const ChainSettings chainSettings, double sampleRate
             );
 }
 
-void AudioPluginAudioProcessor::updatePeakFilter(const ChainSettings&
-                                                 chainSettings)
-{
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients,
-                       peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients,
-                       peakCoefficients);
-};
-
 void updateCoefficients(Coefficients &old, const Coefficients &replacements)
 {
     *old = *replacements;
 };
 
-void AudioPluginAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+void AudioPluginAudioProcessor::applyPublishedCoefficients()
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    if (isUsingDoublePrecision())
+        applyPublishedCoefficients(doubleFilterCascade);
+    else
+        applyPublishedCoefficients(filterCascade);
+}
+
+template<typename SampleType>
+void AudioPluginAudioProcessor::applyPublishedCoefficients(BiquadCascade<SampleType>& cascade)
+{
+    // Left in the buffer until the fade in progress is done, then taken as a
+    // whole, so a crossfade always starts from coefficients that were heard
+    if (cascade.isCrossfading())
+        return;
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    updateCutFilter(leftLowCut,
-                    lowCutCoefficients,
-                    chainSettings.lowCutSlope);
+    auto* coefficients = publishedCoefficients.acquire();
+    if (coefficients == nullptr)
+        return;
 
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    updateCutFilter(rightLowCut,
-                    lowCutCoefficients,
-                    chainSettings.lowCutSlope);
-};
+    // Designs for a new oversampling factor come at the new rate, so the
+    // cascade switches over with them
+    const auto& firstSet = coefficients->channelSets[0];
+    cascade.setOversamplingFactor(juce::roundToInt(firstSet.sampleRate / hostSampleRate.load()));
+
+    // Both channel sets are redesigned together, so share their revisions
+    std::array<bool, 3> stagesToApply;
+    for (size_t i = 0; i < stagesToApply.size(); ++i)
+    {
+        stagesToApply[i] = firstSet.stageRevisions[i] != appliedRevisions[i];
+        appliedRevisions[i] = firstSet.stageRevisions[i];
+    }
+
+    cascade.setCoefficients(*coefficients, stagesToApply);
+    chainIsFlat = coefficients->isFlat();
+}
+
+bool AudioPluginAudioProcessor::designChangedStages(bool forceAll)
+{
+    auto sampleRate = designSampleRate.load();
+    if (sampleRate <= 0)
+        return false;
+
+    auto& coefficients = designedCoefficients;
+    const auto stereoMode = getStereoMode();
+    forceAll = forceAll || sampleRate != coefficients.channelSets[0].sampleRate || stereoMode != coefficients.mode;
+
+    // Snapshot the generations before reading the parameters, so a change that
+    // lands in between is picked up again on the next pass.
+    std::array<bool, 3> changed;
+    bool anyChanged = false;
+
+    for (size_t i = 0; i < stageGenerations.size(); ++i)
+    {
+        auto generation = stageGenerations[i].get();
+        changed[i] = forceAll || generation != designedGenerations[i];
+        designedGenerations[i] = generation;
+        anyChanged = anyChanged || changed[i];
+    }
+
+    if (! anyChanged)
+        return false;
+
+    // Linked channels both follow the first set of parameters
+    const std::array<ChainSettings, NumChannelSets> chainSettings { chainParameters[0].load(),
+                                                                    chainParameters[stereoMode == StereoMode::stereo ? 0 : 1].load() };
+    const auto& table = coefficientTables->getTable(sampleRate);
+    designTable.store(&table);
+    auto& [first, second] = coefficients.channelSets;
+
+    for (int stage = 0; stage < (int) changed.size(); ++stage)
+    {
+        if (! changed[(size_t) stage])
+            continue;
+
+        designStage(stage, chainSettings[0], sampleRate, table, first);
+
+        // Designed once when both sets agree on the stage
+        if (haveSameStageSettings(chainSettings[0], chainSettings[1], stage))
+            copyStage(first, stage, second);
+        else
+            designStage(stage, chainSettings[1], sampleRate, table, second);
+
+        ++first.stageRevisions[(size_t) stage];
+        ++second.stageRevisions[(size_t) stage];
+    }
+
+    coefficients.mode = stereoMode;
+
+    for (size_t set = 0; set < coefficients.channelSets.size(); ++set)
+    {
+        coefficients.channelSets[set].sampleRate = sampleRate;
+        coefficients.channelSets[set].isFlat = isEffectivelyFlat(chainSettings[set], coefficients.channelSets[set]);
+    }
+
+    cascadeTailSeconds.store(getTailLengthInSamples(coefficients, juce::Decibels::decibelsToGain(tailThresholdDecibels))
+                             / sampleRate);
+
+    publishedCoefficients.getWriteSlot() = coefficients;
+    publishedCoefficients.publish();
+    return true;
+}
+
+void AudioPluginAudioProcessor::designStage(int stage, const ChainSettings& chainSettings, double sampleRate,
+                                            const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    const auto inDoublePrecision = designInDoublePrecision.load();
+
+    switch (stage)
+    {
+        case ChainPositions::LowCut:
+            if (inDoublePrecision)
+                designLowCutInDoublePrecision(chainSettings, sampleRate, coefficients);
+            else
+                designLowCut(chainSettings, *coefficientTables, table, coefficients);
+            break;
+        case ChainPositions::Peak:
+            if (inDoublePrecision)
+                designPeakInDoublePrecision(chainSettings, sampleRate, coefficients);
+            else
+                designPeak(chainSettings, *coefficientTables, table, coefficients);
+            break;
+        case ChainPositions::HighCut:
+            if (inDoublePrecision)
+                designHighCutInDoublePrecision(chainSettings, sampleRate, coefficients);
+            else
+                designHighCut(chainSettings, *coefficientTables, table, coefficients);
+            break;
+        default:
+            break;
+    }
+}
+
+bool AudioPluginAudioProcessor::designStageFromTable(int stage, const ChainSettings& chainSettings,
+                                                     const CoefficientTables::Table& table, ChainCoefficients& coefficients)
+{
+    switch (stage)
+    {
+        case ChainPositions::LowCut:  return designLowCutFromTable(chainSettings, *coefficientTables, table, coefficients);
+        case ChainPositions::Peak:    return designPeakFromTable(chainSettings, *coefficientTables, table, coefficients);
+        case ChainPositions::HighCut: return designHighCutFromTable(chainSettings, *coefficientTables, table, coefficients);
+        default: return false;
+    }
+}
+
+void AudioPluginAudioProcessor::requestLinearPhaseKernel(bool chainChanged)
+{
+    const auto settingsChanged = linearPhaseSettingsChanged.exchange(false);
+
+    if ((chainChanged || settingsChanged) && isLinearPhaseEnabled() && designedCoefficients.channelSets[0].sampleRate > 0)
+        linearPhaseFilter.requestKernel(designedCoefficients, hostSampleRate.load(), getLinearPhaseOrder());
+}
+
+void AudioPluginAudioProcessor::designPendingCoefficients()
+{
+    const juce::ScopedLock sl(designLock);
+    requestLinearPhaseKernel(designChangedStages(false));
+}
+
+bool AudioPluginAudioProcessor::isLinearPhaseEnabled() const
+{
+    return linearPhaseParameter->load() > 0.5f;
+}
+
+int AudioPluginAudioProcessor::getLinearPhaseOrder() const
+{
+    return LinearPhaseFilter::MinOrder + (int) linearPhaseLengthParameter->load();
+}
+
+int AudioPluginAudioProcessor::getOversamplingFactor() const
+{
+    return 1 << (int) oversamplingParameter->load();
+}
+
+StereoMode AudioPluginAudioProcessor::getStereoMode() const
+{
+    // The modes only make sense for a pair of channels
+    if (getTotalNumOutputChannels() != 2)
+        return StereoMode::stereo;
+
+    return static_cast<StereoMode>((int) stereoModeParameter->load());
+}
 
-void AudioPluginAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+void AudioPluginAudioProcessor::updateLatency()
 {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    setLatencySamples(isLinearPhaseEnabled() ? LinearPhaseFilter::getLatencyInSamples(getLinearPhaseOrder())
+                                             : juce::roundToInt(BiquadCascadeBase::getOversamplingLatency(getOversamplingFactor())));
+}
 
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    updateCutFilter(leftHighCut,
-                    highCutCoefficients,
-                    chainSettings.highCutSlope);
+void AudioPluginAudioProcessor::requestLatencyUpdate()
+{
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        updateLatency();
+        return;
+    }
 
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    updateCutFilter(rightHighCut,
-                    highCutCoefficients,
-                    chainSettings.highCutSlope);
+    // Only the first change since the last update posts a message
+    if (! latencyUpdatePending.exchange(true))
+        triggerAsyncUpdate();
+}
+
+void AudioPluginAudioProcessor::handleAsyncUpdate()
+{
+    latencyUpdatePending = false;
+    updateLatency();
 }
 
 void AudioPluginAudioProcessor::updateFilters()
 {
-    auto chainSettings = getChainSettings(apvts);
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
+    {
+        const juce::ScopedLock sl(designLock);
+        requestLinearPhaseKernel(designChangedStages(true));
+    }
+
+    // Only called while the audio thread isn't processing, so this thread
+    // can stand in as the reader of the published coefficients.
+    applyPublishedCoefficients();
+}
+
+void AudioPluginAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(newValue);
+
+    // Parameter IDs are prefixed with the stage they belong to
+    if (parameterID.startsWith("LowCut"))
+        ++stageGenerations[ChainPositions::LowCut];
+    else if (parameterID.startsWith("Peak"))
+        ++stageGenerations[ChainPositions::Peak];
+    else if (parameterID.startsWith("HighCut"))
+        ++stageGenerations[ChainPositions::HighCut];
+    else if (parameterID.startsWith("Linear Phase"))
+    {
+        linearPhaseSettingsChanged = true;
+        requestLatencyUpdate();
+    }
+    else if (parameterID == "Oversampling")
+    {
+        // Every stage is redesigned for the new rate
+        if (const auto sampleRate = hostSampleRate.load(); sampleRate > 0)
+            designSampleRate.store(sampleRate * getOversamplingFactor());
+
+        requestLatencyUpdate();
+    }
+    else if (parameterID == "Stereo Mode")
+    {
+        // designChangedStages() redesigns every stage when the mode changes
+    }
+    else
+        return;
+
+    // Automation arrives on the audio thread, which must not take the designer's
+    // lock; it's picked up on the designer's next poll instead.
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        designerThread->triggerDesign();
 }
 
 bool AudioPluginAudioProcessor::acceptsMidi() const
@@ -124,7 +338,17 @@ bool AudioPluginAudioProcessor::isMidiEffect() const
 
 double AudioPluginAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    const auto sampleRate = hostSampleRate.load();
+    if (sampleRate <= 0)
+        return 0.0;
+
+    // The FIR rings for exactly its length
+    if (isLinearPhaseEnabled())
+        return (double) ((1 << getLinearPhaseOrder()) - 1) / sampleRate;
+
+    const auto threshold = juce::Decibels::decibelsToGain(tailThresholdDecibels);
+    return cascadeTailSeconds.load()
+         + BiquadCascadeBase::getOversamplingTailLength(getOversamplingFactor(), threshold) / sampleRate;
 }
 
 int AudioPluginAudioProcessor::getNumPrograms()
@@ -164,13 +388,47 @@ void AudioPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
     juce::dsp::ProcessSpec spec;
 
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = (juce::uint32) juce::jmax(1, getTotalNumOutputChannels());
 
     spec.sampleRate = sampleRate;
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // The host picks the precision before preparing, and keeps it until the next prepare
+    const auto useDoublePrecision = isUsingDoublePrecision();
+
+    if (useDoublePrecision)
+    {
+        doubleFilterCascade.prepare(spec);
+        doubleIdentityMixer.prepare(spec);
+        doubleIdentityMixer.setMixingRule(juce::dsp::DryWetMixingRule::linear);
+    }
+    else
+    {
+        filterCascade.prepare(spec);
+        identityMixer.prepare(spec);
+        identityMixer.setMixingRule(juce::dsp::DryWetMixingRule::linear);
+    }
+
+    linearPhaseFilter.prepare(spec);
+    linearPhaseBuffer.setSize((int) spec.numChannels, samplesPerBlock, false, false, true);
+    updateLatency();
+    smoothingRampSamples = juce::roundToInt(sampleRate * smoothingTimeSeconds);
+    crossfadeSamples = juce::roundToInt(sampleRate * crossfadeTimeSeconds);
+    identityFadeSamples = juce::roundToInt(sampleRate * identityFadeTimeSeconds);
+    identityFadeSamplesRemaining = 0;
+    identityEngaged = false;    // The mixers were just reset to the wet signal
+
+    // Spawned up front so switching to multithreaded processing never starts a thread
+    // on the audio thread. The audio thread takes a group itself, hence the - 1.
+    const auto numLaneGroups = useDoublePrecision ? doubleFilterCascade.getMaxNumLaneGroups()
+                                               : filterCascade.getMaxNumLaneGroups();
+    channelWorkers.setNumWorkers(juce::jmin(numLaneGroups - 1,
+                                            juce::SystemStats::getNumCpus() - 1));
+
+    hostSampleRate.store(sampleRate);
+    designInDoublePrecision.store(useDoublePrecision);
+    designSampleRate.store(sampleRate * getOversamplingFactor());
     updateFilters();
+    subBlockSettings = loadChainSettings();
 
     leftChannelFifo.prepare(samplesPerBlock);
     rightChannelFifo.prepare(samplesPerBlock);
@@ -186,6 +444,7 @@ void AudioPluginAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    channelWorkers.setNumWorkers(0);
 }
 
 bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -194,12 +453,9 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // The cascade runs on any number of channels, one SIMD lane each, so any
+    // layout works as long as the main bus isn't disabled.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -216,7 +472,207 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                               juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
+    processSamples(buffer, filterCascade);
+}
+
+void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                              juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processSamples(buffer, doubleFilterCascade);
+}
+
+template<typename SampleType>
+juce::dsp::DryWetMixer<SampleType>& AudioPluginAudioProcessor::getIdentityMixer()
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleIdentityMixer;
+    else
+        return identityMixer;
+}
+
+template<typename SampleType>
+void AudioPluginAudioProcessor::processCascade(const juce::dsp::AudioBlock<SampleType>& block, BiquadCascade<SampleType>& cascade)
+{
+    auto& mixer = getIdentityMixer<SampleType>();
+
+    if (chainIsFlat != identityEngaged)
+    {
+        // Coming back from the dry signal, the cascade starts from silence
+        if (identityEngaged && identityFadeSamplesRemaining == 0)
+            cascade.reset();
+
+        identityEngaged = chainIsFlat;
+        identityFadeSamplesRemaining = identityFadeSamples;
+        mixer.setWetMixProportion(identityEngaged ? SampleType(0) : SampleType(1));
+    }
+
+    const auto latency = BiquadCascadeBase::getOversamplingLatency(cascade.getOversamplingFactor());
+    const auto fading = identityFadeSamplesRemaining > 0;
+
+    // A fade the cascade has started still has to finish before it takes new designs
+    const auto runCascade = ! identityEngaged || fading || cascade.isCrossfading();
+    const auto mixDry = fading || (identityEngaged && latency > 0);
+
+    if (mixDry)
+    {
+        mixer.setWetLatency((SampleType) latency);
+        mixer.pushDrySamples(block);
+    }
+
+    if (runCascade)
+        filterInSubBlocks(block, cascade);
+    else
+        subBlockSettings = loadChainSettings();
+
+    if (mixDry)
+        mixer.mixWetSamples(block);
+
+    identityFadeSamplesRemaining = juce::jmax(0, identityFadeSamplesRemaining - (int) block.getNumSamples());
+}
+
+std::array<ChainSettings, NumChannelSets> AudioPluginAudioProcessor::loadChainSettings() const
+{
+    // Linked channels both follow the first set, as in designChangedStages()
+    return { chainParameters[0].load(), chainParameters[getStereoMode() == StereoMode::stereo ? 0 : 1].load() };
+}
+
+template<typename SampleType>
+void AudioPluginAudioProcessor::filterInSubBlocks(const juce::dsp::AudioBlock<SampleType>& block, BiquadCascade<SampleType>& cascade)
+{
+    const auto start = subBlockSettings;
+    const auto end = loadChainSettings();
+    subBlockSettings = end;
+
+    // Only the stages whose settings moved are interpolated; the rest are
+    // left to the designer
+    std::array<bool, 3> movingStages {};
+    bool anyMoving = false;
+
+    for (int stage = 0; stage < (int) movingStages.size(); ++stage)
+    {
+        for (size_t set = 0; set < start.size(); ++set)
+            movingStages[(size_t) stage] = movingStages[(size_t) stage] || ! haveSameStageSettings(start[set], end[set], stage);
 
+        anyMoving = anyMoving || movingStages[(size_t) stage];
+    }
+
+    // The tables have to match the rate the cascade runs at; just after a
+    // change of rate the designer hasn't caught up yet
+    const auto* table = designTable.load();
+    const auto numSamples = block.getNumSamples();
+    const auto rate = hostSampleRate.load() * cascade.getOversamplingFactor();
+
+    if (! anyMoving || numSamples <= (size_t) subBlockSize || table == nullptr || table->sampleRate != rate)
+    {
+        if (multithreadedChannelsParameter->load() > 0.5f)
+            cascade.process(block, channelWorkers);
+        else
+            cascade.process(block);
+
+        return;
+    }
+
+    // Sub-blocks stay on this thread: waking the workers and meeting them at
+    // the barrier every subBlockSize samples costs more than it saves
+
+    subBlockCoefficients.mode = getStereoMode();
+    auto previous = start;
+    bool first = true;
+    bool onGrid = true;
+    bool anyApplied = false;
+
+    for (size_t offset = 0; offset < numSamples; offset += (size_t) subBlockSize)
+    {
+        const auto length = juce::jmin((size_t) subBlockSize, numSamples - offset);
+        const auto amount = (float) (offset + length) / (float) numSamples;
+
+        // A crossfade in progress has to finish first; whatever it missed is
+        // picked up at the next boundary after it
+        if (onGrid && ! cascade.isCrossfading())
+        {
+            std::array<ChainSettings, NumChannelSets> settings;
+            for (size_t set = 0; set < settings.size(); ++set)
+                settings[set] = interpolateChainSettings(start[set], end[set], amount);
+
+            std::array<bool, 3> stagesToApply {};
+            bool anyToApply = false;
+
+            for (int stage = 0; stage < (int) stagesToApply.size(); ++stage)
+            {
+                if (! movingStages[(size_t) stage])
+                    continue;
+
+                // Rounded to the parameter steps, slow moves often land on the same values
+                auto& apply = stagesToApply[(size_t) stage];
+                apply = first;
+
+                for (size_t set = 0; set < settings.size(); ++set)
+                    apply = apply || ! haveSameStageSettings(previous[set], settings[set], stage);
+
+                if (! apply)
+                    continue;
+
+                auto& [firstSet, secondSet] = subBlockCoefficients.channelSets;
+                onGrid = designStageFromTable(stage, settings[0], *table, firstSet);
+
+                if (haveSameStageSettings(settings[0], settings[1], stage))
+                    copyStage(firstSet, stage, secondSet);
+                else
+                    onGrid = onGrid && designStageFromTable(stage, settings[1], *table, secondSet);
+
+                if (! onGrid)
+                    break;
+
+                anyToApply = true;
+            }
+
+            // Off the grid the rest of the block keeps the last design, and
+            // the designer's takes over from the next one
+            if (onGrid && anyToApply)
+            {
+                cascade.setCoefficients(subBlockCoefficients, stagesToApply);
+                anyApplied = true;
+            }
+
+            previous = settings;
+            first = false;
+        }
+
+        cascade.process(block.getSubBlock(offset, length));
+    }
+
+    if (anyApplied)
+    {
+        // The cascade now holds designs the designer never saw, so it mustn't
+        // be swapped for the dry signal on the strength of an older one. The
+        // moving stages are asked for again, so the designer publishes the
+        // final design with its flatness and tail worked out.
+        chainIsFlat = false;
+
+        for (size_t stage = 0; stage < movingStages.size(); ++stage)
+            if (movingStages[stage])
+                ++stageGenerations[stage];
+    }
+}
+
+template<typename SampleType>
+bool AudioPluginAudioProcessor::isDigitalSilence(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* samples = block.getChannelPointer(channel);
+
+        if (std::any_of(samples, samples + block.getNumSamples(), [](SampleType sample) { return sample != 0; }))
+            return false;
+    }
+
+    return true;
+}
+
+template<typename SampleType>
+void AudioPluginAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, BiquadCascade<SampleType>& cascade)
+{
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -230,21 +686,105 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    // Before applying anything, so new coefficients are laid out for the form in use
+    switch (static_cast<AutomationSmoothing>(automationSmoothingParameter->load()))
+    {
+        case Ramp:
+            cascade.setUpdateMode(BiquadCascadeBase::UpdateMode::ramped, smoothingRampSamples);
+            break;
+        case Crossfade:
+            cascade.setUpdateMode(BiquadCascadeBase::UpdateMode::crossfade, crossfadeSamples);
+            break;
+        default:
+            cascade.setUpdateMode(BiquadCascadeBase::UpdateMode::immediate, 0);
+            break;
+    }
+
+    applyPublishedCoefficients(cascade);
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    juce::dsp::AudioBlock<SampleType> block(buffer);
 
     /* Test Oscillator */
     // buffer.clear();
     // juce::dsp::ProcessContextReplacing<float> stereoContext(block);
     // osc.process(stereoContext);
 
-    auto LeftBlock = block.getSingleChannelBlock(0);
-    auto RightBlock = block.getSingleChannelBlock(1);
-    juce::dsp::ProcessContextReplacing<float> leftContext(LeftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(RightBlock);
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    // Every channel goes through the cascade, one per SIMD lane
+    auto numChannels = juce::jmin(block.getNumChannels(), cascade.getMaxNumChannels());
+    auto filterBlock = block.getSubsetChannelBlock(0, numChannels);
+
+    // Each path starts from silence when switched to
+    if (const auto linearPhase = isLinearPhaseEnabled(); linearPhase != linearPhaseActive)
+    {
+        linearPhaseActive = linearPhase;
+
+        if (linearPhaseActive)
+            linearPhaseFilter.reset();
+        else
+            cascade.reset();
+    }
+
+    // Once the input is digital silence and the tail has died away, the output
+    // is silence too. A block with any sound in it is processed whole, from
+    // cleared state, so filtering picks up on the exact sample it arrives.
+    const auto blockLength = filterBlock.getNumSamples();
+    const auto inputSilent = isDigitalSilence(filterBlock);
+    const auto tailDone = inputSilent && ! cascade.isCrossfading()
+                       && (double) silentInputSamples >= getTailLengthSeconds() * hostSampleRate.load();
+
+    silentInputSamples = inputSilent ? silentInputSamples + (juce::int64) blockLength : 0;
+
+    if (tailDone)
+    {
+        if (! filtersIdle)
+        {
+            filtersIdle = true;
+            cascade.reset();
+            linearPhaseFilter.reset();
+        }
+
+        subBlockSettings = loadChainSettings();
+        return;
+    }
+
+    filtersIdle = false;
+
+    if (linearPhaseActive)
+    {
+        // The FIR follows the designer only
+        subBlockSettings = loadChainSettings();
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            linearPhaseFilter.process(filterBlock);
+        }
+        else
+        {
+            // Round trips through float, the FIR can't use the extra precision anyway
+            auto floatBlock = juce::dsp::AudioBlock<float>(linearPhaseBuffer)
+                                  .getSubBlock(0, blockLength)
+                                  .getSubsetChannelBlock(0, filterBlock.getNumChannels());
+
+            for (size_t channel = 0; channel < filterBlock.getNumChannels(); ++channel)
+            {
+                auto* samples = filterBlock.getChannelPointer(channel);
+                std::transform(samples, samples + blockLength, floatBlock.getChannelPointer(channel),
+                               [](SampleType sample) { return static_cast<float>(sample); });
+            }
+
+            linearPhaseFilter.process(floatBlock);
+
+            for (size_t channel = 0; channel < filterBlock.getNumChannels(); ++channel)
+            {
+                auto* samples = floatBlock.getChannelPointer(channel);
+                std::copy(samples, samples + blockLength, filterBlock.getChannelPointer(channel));
+            }
+        }
+    }
+    else
+    {
+        processCascade(filterBlock, cascade);
+    }
 
     leftChannelFifo.update(buffer);
     rightChannelFifo.update(buffer);
@@ -280,29 +820,124 @@ void AudioPluginAudioProcessor::setStateInformation (const void* data, int sizeI
     if (tree.isValid())
     {
         apvts.replaceState(tree);
-        updateFilters();
+        designerThread->triggerDesign();
     };
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet)
+{
+    return ChainParameters(apvts, channelSet).load();
+}
+
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apvts, int channelSet)
+{
+    const juce::String suffix = channelSet == 0 ? "" : " 2";
+
+    auto get = [&apvts, &suffix](const juce::String& parameterID)
+    {
+        auto* value = apvts.getRawParameterValue(parameterID + suffix);
+        jassert(value != nullptr);
+        return value;
+    };
+
+    lowCutFreq = get("LowCut Freq");
+    highCutFreq = get("HighCut Freq");
+    lowCutSlope = get("LowCut Slope");
+    highCutSlope = get("HighCut Slope");
+    lowCutBypassed = get("LowCut Bypassed");
+    highCutBypassed = get("HighCut Bypassed");
+
+    for (int band = 0; band < (int) peakBands.size(); ++band)
+    {
+        peakBands[(size_t) band] = { get(getPeakBandParameterID(band, "Freq")),
+                                     get(getPeakBandParameterID(band, "Gain")),
+                                     get(getPeakBandParameterID(band, "Quality")),
+                                     get(getPeakBandParameterID(band, "Bypassed")) };
+    }
+}
+
+ChainSettings ChainParameters::load() const
 {
     ChainSettings settings;
 
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    settings.lowCutFreq = lowCutFreq->load();
+    settings.highCutFreq = highCutFreq->load();
+    settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load());
+    settings.highCutSlope = static_cast<Slope>(highCutSlope->load());
+    settings.lowCutBypassed = lowCutBypassed->load() > 0.5f;
+    settings.highCutBypassed = highCutBypassed->load() > 0.5f;
 
-    settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
-    settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
-    settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
+    auto loadBand = [](const PeakBand& parameters)
+    {
+        return PeakBandSettings { parameters.freq->load(), parameters.gain->load(),
+                                  parameters.quality->load(), parameters.bypassed->load() > 0.5f };
+    };
+
+    const auto first = loadBand(peakBands[0]);
+    settings.peakFreq = first.freq;
+    settings.peakGainInDecibels = first.gainInDecibels;
+    settings.peakQuality = first.quality;
+    settings.peakBypassed = first.bypassed;
+
+    for (size_t i = 0; i < settings.extraPeaks.size(); ++i)
+        settings.extraPeaks[i] = loadBand(peakBands[i + 1]);
 
     return settings;
 }
 
+ChainSettings interpolateChainSettings(const ChainSettings& start, const ChainSettings& end, float amount)
+{
+    // Frequencies move evenly in octaves, like the sliders' skew suggests
+    // Kept within the parameter ranges as well as on their steps, so every
+    // value lands on the CoefficientTables grid
+    auto frequency = [amount](float from, float to)
+    {
+        if (from <= 0 || to <= 0)
+            return to;
+
+        return (float) juce::jlimit(CoefficientTables::MinFrequency, CoefficientTables::MaxFrequency,
+                                    juce::roundToInt(from * std::pow(to / from, amount)));
+    };
+
+    auto step = [amount](float from, float to, float interval)
+    {
+        return interval * (float) juce::roundToInt((from + (to - from) * amount) / interval);
+    };
+
+    constexpr auto maxGainDb = CoefficientTables::MinGainDb + (CoefficientTables::NumGains - 1) * CoefficientTables::GainStepDb;
+
+    auto gain = [&step](float from, float to)
+    {
+        return juce::jlimit(CoefficientTables::MinGainDb, maxGainDb, step(from, to, CoefficientTables::GainStepDb));
+    };
+
+    auto settings = end;
+    settings.lowCutFreq = frequency(start.lowCutFreq, end.lowCutFreq);
+    settings.highCutFreq = frequency(start.highCutFreq, end.highCutFreq);
+    settings.peakFreq = frequency(start.peakFreq, end.peakFreq);
+    settings.peakGainInDecibels = gain(start.peakGainInDecibels, end.peakGainInDecibels);
+    settings.peakQuality = step(start.peakQuality, end.peakQuality, 0.05f);
+
+    for (size_t i = 0; i < settings.extraPeaks.size(); ++i)
+    {
+        const auto& from = start.extraPeaks[i];
+        auto& band = settings.extraPeaks[i];
+        band.freq = frequency(from.freq, end.extraPeaks[i].freq);
+        band.gainInDecibels = gain(from.gainInDecibels, end.extraPeaks[i].gainInDecibels);
+        band.quality = step(from.quality, end.extraPeaks[i].quality, 0.05f);
+    }
+
+    return settings;
+}
+
+juce::String getPeakBandParameterID(int band, const juce::String& parameter)
+{
+    if (band == 0)
+        return "Peak " + parameter;
+
+    return "Peak " + juce::String(band + 1) + " " + parameter;
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout
     AudioPluginAudioProcessor::createParameterLayout()
     {
@@ -344,6 +979,81 @@ juce::AudioProcessorValueTreeState::ParameterLayout
         layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
         layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));
         layout.add(std::make_unique<juce::AudioParameterBool>("Analyser Bypassed", "Analyser Bypassed", true));
+        layout.add(std::make_unique<juce::AudioParameterBool>("Multithreaded Channels", "Multithreaded Channels", false));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Automation Smoothing", "Automation Smoothing",
+                                                                juce::StringArray { "Off", "Ramp", "Crossfade" }, 0));
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+                                                                juce::StringArray { "Off", "2x", "4x" }, 0));
+
+        layout.add(std::make_unique<juce::AudioParameterBool>("Linear Phase", "Linear Phase", false));
+
+        juce::StringArray firLengths;
+        for (int order = LinearPhaseFilter::MinOrder; order <= LinearPhaseFilter::MaxOrder; ++order)
+            firLengths.add(juce::String(1 << order) + " taps");
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Linear Phase Length", "Linear Phase Length", firLengths, 1));
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Stereo Mode", "Stereo Mode",
+                                                                juce::StringArray { "Stereo", "Mid/Side", "Dual Mono" }, 0));
+
+        // The right or side channel's bands, for the Mid/Side and Dual Mono modes.
+        // Their IDs start with the stage's name too, so parameterChanged() files them the same.
+        layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq 2", "LowCut Freq 2",
+                                    juce::NormalisableRange<float>(20.f,20000.f,1.f,0.25f),
+                                    20.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq 2", "HighCut Freq 2",
+                                    juce::NormalisableRange<float>(20.f,20000.f,1.f,0.25f),
+                                    20000.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq 2", "Peak Freq 2",
+                                    juce::NormalisableRange<float>(20.f,20000.f,1.f,0.25f),
+                                    750.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain 2", "Peak Gain 2",
+                                                               juce::NormalisableRange<float>(-24.f,24.f,0.5f,1.f),
+                                                               0.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality 2", "Peak Quality 2",
+                                                               juce::NormalisableRange<float>(0.1f,10.f,0.05f,1.f),
+                                                               1.f));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope 2", "LowCut Slope 2", stringArray, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope 2", "HighCut Slope 2", stringArray, 0));
+        layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypassed 2", "LowCut Bypassed 2", false));
+        layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed 2", "Peak Bypassed 2", false));
+        layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed 2", "HighCut Bypassed 2", false));
+
+        // "Peak 2" to "Peak 16" for each channel set. They start bypassed, so they
+        // cost nothing until they're switched on, at frequencies spread over the spectrum.
+        for (const juce::String suffix : { "", " 2" })
+        {
+            for (int band = 1; band < ChainCoefficients::MaxPeakBands; ++band)
+            {
+                const auto position = (float) (band - 1) / (float) (ChainCoefficients::MaxPeakBands - 2);
+                const auto defaultFreq = std::round(40.f * std::pow(400.f, position));
+
+                auto id = [&](const char* parameter) { return getPeakBandParameterID(band, parameter) + suffix; };
+
+                layout.add(std::make_unique<juce::AudioParameterFloat>(id("Freq"), id("Freq"),
+                                            juce::NormalisableRange<float>(20.f,20000.f,1.f,0.25f),
+                                            defaultFreq));
+                layout.add(std::make_unique<juce::AudioParameterFloat>(id("Gain"), id("Gain"),
+                                                                       juce::NormalisableRange<float>(-24.f,24.f,0.5f,1.f),
+                                                                       0.0f));
+                layout.add(std::make_unique<juce::AudioParameterFloat>(id("Quality"), id("Quality"),
+                                                                       juce::NormalisableRange<float>(0.1f,10.f,0.05f,1.f),
+                                                                       1.f));
+                layout.add(std::make_unique<juce::AudioParameterBool>(id("Bypassed"), id("Bypassed"), true));
+            }
+        }
+
+        // Display only; read by the editor's analyser
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Analyser Resolution", "Analyser Resolution",
+                                                                juce::StringArray { "2048", "4096", "8192" }, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Analyser Window", "Analyser Window",
+                                                                juce::StringArray { "Blackman-Harris", "Hann", "Hamming", "Blackman", "Flat Top" }, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Analyser Overlap", "Analyser Overlap",
+                                                                juce::StringArray { "0% Overlap", "25% Overlap", "50% Overlap", "75% Overlap" }, 2));
+
+        // Shows how many FFTs the analyser ran against how many frames it drew
+        layout.add(std::make_unique<juce::AudioParameterBool>("Analyser Stats", "Analyser Stats", false));
 
         return layout;
     }
@@ -3,6 +3,12 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 #include <array>
+#include <atomic>
+
+#include "BiquadCascade.h"
+#include "ButterworthDesignCache.h"
+#include "CoefficientDesigner.h"
+#include "LinearPhaseFilter.h"
 
 
 //======================================================================
@@ -83,15 +89,19 @@ struct SingleChannelSampleFifo
         prepared.set(false);
     }
 
-    void update(const BlockType& buffer)
+    // Double precision buffers are rounded to float on the way in
+    template<typename SampleType>
+    void update(const juce::AudioBuffer<SampleType>& buffer)
     {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse );
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        jassert(buffer.getNumChannels() > 0);
+
+        // A mono bus feeds both analyzers from its only channel
+        auto* channelPtr = buffer.getReadPointer(juce::jmin((int) channelToUse, buffer.getNumChannels() - 1));
 
         for (int i = 0; i < buffer.getNumSamples(); ++i)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            pushNextSampleIntoFifo(static_cast<float>(channelPtr[i]));
         }
     }
 
@@ -147,15 +157,75 @@ enum Slope
     Slope_48
 };
 
+// Choices of the "Automation Smoothing" parameter
+enum AutomationSmoothing
+{
+    Off,
+    Ramp,
+    Crossfade
+};
+
+struct PeakBandSettings
+{
+    float freq {0}, gainInDecibels {0}, quality {1};
+    bool bypassed { false };
+};
+
 struct ChainSettings
 {
     float peakFreq {0}, peakGainInDecibels {0}, peakQuality {0};
     float lowCutFreq {0}, highCutFreq {0};
     Slope lowCutSlope {Slope::Slope_12}, highCutSlope {Slope::Slope_12};
     bool lowCutBypassed { false }, peakBypassed { false }, highCutBypassed { false };
+
+    // The "Peak 2" to "Peak 16" bands
+    std::array<PeakBandSettings, ChainCoefficients::MaxPeakBands - 1> extraPeaks;
+
+    // Band 0 is "Peak"
+    PeakBandSettings getPeakBand(int band) const
+    {
+        if (band == 0)
+            return { peakFreq, peakGainInDecibels, peakQuality, peakBypassed };
+
+        return extraPeaks[(size_t) (band - 1)];
+    }
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+// channelSet 1 reads the second set of band parameters, the ones with a " 2" suffix
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet = 0);
+
+// The raw values behind one channel set's ChainSettings, looked up once so
+// they can be read on the audio thread without building any IDs
+struct ChainParameters
+{
+    ChainParameters(juce::AudioProcessorValueTreeState& apvts, int channelSet);
+
+    ChainSettings load() const;
+private:
+    struct PeakBand
+    {
+        std::atomic<float>* freq;
+        std::atomic<float>* gain;
+        std::atomic<float>* quality;
+        std::atomic<float>* bypassed;
+    };
+
+    std::atomic<float>* lowCutFreq;
+    std::atomic<float>* highCutFreq;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* lowCutBypassed;
+    std::atomic<float>* highCutBypassed;
+    std::array<PeakBand, ChainCoefficients::MaxPeakBands> peakBands;
+};
+
+// The continuous parameters amount of the way from start to end, rounded to
+// the steps of their ranges so the tables always have them. Slopes and
+// bypasses are taken from end.
+ChainSettings interpolateChainSettings(const ChainSettings& start, const ChainSettings& end, float amount);
+
+// "Peak Freq" for band 0, then "Peak 2 Freq" and so on
+juce::String getPeakBandParameterID(int band, const juce::String& parameter);
 
     using Filter = juce::dsp::IIR::Filter<float>;
 
@@ -217,24 +287,26 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
         };
     };
 
+// Both go through the shared ButterworthDesignCache, so repeated designs are free
 inline auto makeLowCutFilter(const ChainSettings chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>
-        ::designIIRHighpassHighOrderButterworthMethod(
-            chainSettings.lowCutFreq, sampleRate,
-            (chainSettings.lowCutSlope + 1) * 2);
+    juce::SharedResourcePointer<ButterworthDesignCache> cache;
+    return cache->getHighPass(chainSettings.lowCutFreq, sampleRate,
+                              (chainSettings.lowCutSlope + 1) * 2);
 }
 
 inline auto makeHighCutFilter(const ChainSettings chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>
-        ::designIIRLowpassHighOrderButterworthMethod(
-            chainSettings.highCutFreq, sampleRate,
-            (chainSettings.highCutSlope + 1) * 2);
+    juce::SharedResourcePointer<ButterworthDesignCache> cache;
+    return cache->getLowPass(chainSettings.highCutFreq, sampleRate,
+                             (chainSettings.highCutSlope + 1) * 2);
 }
 
 //==============================================================================
-class AudioPluginAudioProcessor  : public juce::AudioProcessor
+class AudioPluginAudioProcessor  : public juce::AudioProcessor,
+                                   private juce::AudioProcessorValueTreeState::Listener,
+                                   private CoefficientDesignerThread::Client,
+                                   private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -248,7 +320,9 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-    using AudioProcessor::processBlock;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -279,8 +353,7 @@ public:
                                               "parameters",
                                               createParameterLayout()};
 
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
+    // Designs and applies every stage synchronously. Never call this while processing.
     void updateFilters();
 
     using BlockType = juce::AudioBuffer<float>;
@@ -288,9 +361,143 @@ public:
     SingleChannelSampleFifo<BlockType> rightChannelFifo { Channel::Right };
 
 private:
-    MonoChain leftChain, rightChain;
-
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    // Looked up once, so reading them on the audio thread never builds a parameter ID
+    std::atomic<float>* linearPhaseParameter = apvts.getRawParameterValue("Linear Phase");
+    std::atomic<float>* linearPhaseLengthParameter = apvts.getRawParameterValue("Linear Phase Length");
+    std::atomic<float>* oversamplingParameter = apvts.getRawParameterValue("Oversampling");
+    std::atomic<float>* stereoModeParameter = apvts.getRawParameterValue("Stereo Mode");
+    std::atomic<float>* multithreadedChannelsParameter = apvts.getRawParameterValue("Multithreaded Channels");
+    std::atomic<float>* automationSmoothingParameter = apvts.getRawParameterValue("Automation Smoothing");
+
+    // Every channel of the bus runs through the cascade, one per SIMD lane.
+    // Only the one matching the host's processing precision is prepared.
+    BiquadCascade<float> filterCascade;
+    BiquadCascade<double> doubleFilterCascade;
+
+    // Shares wide buses' lane groups out when "Multithreaded Channels" is on
+    ChannelWorkerPool channelWorkers;
+
+    // With "Automation Smoothing" on Ramp, each new design is glided to over this long.
+    // A few designer polls, so continuous automation keeps gliding between them.
+    static constexpr double smoothingTimeSeconds = 0.01;
+    int smoothingRampSamples = 0;
+
+    // On Crossfade, the old and new chains are faded over this long. Designs
+    // published meanwhile wait, so it's kept short.
+    static constexpr double crossfadeTimeSeconds = 0.005;
+    int crossfadeSamples = 0;
+
+    // Tails are measured down to this. Once the input has been digital silence
+    // for that long, the filters and analyzers are skipped until audio returns.
+    static constexpr double tailThresholdDecibels = -120.0;
+    std::atomic<double> cascadeTailSeconds { 0.0 };     // Of the newest design
+    juce::int64 silentInputSamples = 0;                 // Audio side
+    bool filtersIdle = false;
+
+    // While the design is flat the cascade is left out, and the dry signal,
+    // delayed to match the oversampling latency, is faded to and from.
+    // DryWetMixer always ramps over 50 ms.
+    static constexpr double identityFadeTimeSeconds = 0.05;
+    static constexpr int maxIdentityLatency = 8;
+    juce::dsp::DryWetMixer<float> identityMixer { maxIdentityLatency };
+    juce::dsp::DryWetMixer<double> doubleIdentityMixer { maxIdentityLatency };
+    bool chainIsFlat = false;           // Audio side, from the applied design
+    bool identityEngaged = false;
+    int identityFadeSamples = 0, identityFadeSamplesRemaining = 0;
+
+    // Hosts only hand over one value per parameter per block, so a big block
+    // (an offline bounce, say) would jump to its new settings in one go. When
+    // the settings moved since the last block, the cascade runs this many
+    // samples at a time instead, with the settings interpolated across the
+    // block and designed from the tables in between.
+    static constexpr int subBlockSize = 32;
+    std::array<ChainParameters, NumChannelSets> chainParameters { ChainParameters(apvts, 0), ChainParameters(apvts, 1) };
+    std::array<ChainSettings, NumChannelSets> subBlockSettings;  // Audio side, where the last block ended
+    StereoChainCoefficients subBlockCoefficients;
+    std::atomic<const CoefficientTables::Table*> designTable { nullptr };   // Of the newest design
+
+    // With "Linear Phase" on, a symmetric FIR of the same response replaces the
+    // cascade, and the plugin reports its delay as latency
+    LinearPhaseFilter linearPhaseFilter;
+    juce::AudioBuffer<float> linearPhaseBuffer;     // Convolution only runs in float
+    std::atomic<bool> linearPhaseSettingsChanged { true };
+    bool linearPhaseActive = false;     // Audio side
+
+    // Bumped by parameterChanged() whenever one of a stage's parameters moves.
+    // The designer compares against the generation it last designed.
+    std::array<juce::Atomic<juce::uint32>, 3> stageGenerations;
+
+    // Designer side: only touched with designLock held
+    juce::CriticalSection designLock;
+    std::array<juce::uint32, 3> designedGenerations { 0, 0, 0 };
+    StereoChainCoefficients designedCoefficients;
+    std::atomic<double> designSampleRate { 0.0 };   // The host's times the oversampling factor
+    std::atomic<double> hostSampleRate { 0.0 };
+    std::atomic<bool> designInDoublePrecision { false };    // Bypasses the float tables and cache
+
+    // Designs are handed to the audio thread through here
+    TripleBuffer<StereoChainCoefficients> publishedCoefficients;
+
+    // Audio side
+    std::array<juce::uint32, 3> appliedRevisions { 0, 0, 0 };
+
+    juce::SharedResourcePointer<CoefficientDesignerThread> designerThread;
+
+    // Trig terms for every quantised parameter value, shared by every instance
+    juce::SharedResourcePointer<CoefficientTables> coefficientTables;
+
+    // Keeps the design cache alive between makeLowCutFilter/makeHighCutFilter calls
+    juce::SharedResourcePointer<ButterworthDesignCache> butterworthDesignCache;
+
+    // Returns true if any stage was redesigned
+    bool designChangedStages(bool forceAll);
+    void designStage(int stage, const ChainSettings& chainSettings, double sampleRate,
+                     const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+    void designPendingCoefficients() override;
+
+    // From the tables alone, so it never locks or allocates and is safe on the
+    // audio thread. False if a setting is off the grid.
+    bool designStageFromTable(int stage, const ChainSettings& chainSettings,
+                              const CoefficientTables::Table& table, ChainCoefficients& coefficients);
+
+    // Designer side, with designLock held
+    void requestLinearPhaseKernel(bool chainChanged);
+
+    bool isLinearPhaseEnabled() const;
+    int getLinearPhaseOrder() const;
+    int getOversamplingFactor() const;
+    StereoMode getStereoMode() const;
+    void updateLatency();
+
+    // setLatencySamples() calls back into the host, so a change that arrives on
+    // the audio thread is handed to the message thread
+    void requestLatencyUpdate();
+    void handleAsyncUpdate() override;
+    std::atomic<bool> latencyUpdatePending { false };
+    void applyPublishedCoefficients();
+
+    template<typename SampleType>
+    void applyPublishedCoefficients(BiquadCascade<SampleType>& cascade);
+
+    template<typename SampleType>
+    juce::dsp::DryWetMixer<SampleType>& getIdentityMixer();
+
+    template<typename SampleType>
+    void processCascade(const juce::dsp::AudioBlock<SampleType>& block, BiquadCascade<SampleType>& cascade);
+
+    // Audio side
+    std::array<ChainSettings, NumChannelSets> loadChainSettings() const;
+
+    template<typename SampleType>
+    void filterInSubBlocks(const juce::dsp::AudioBlock<SampleType>& block, BiquadCascade<SampleType>& cascade);
+
+    template<typename SampleType>
+    static bool isDigitalSilence(const juce::dsp::AudioBlock<SampleType>& block);
+
+    template<typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, BiquadCascade<SampleType>& cascade);
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
 
     /* Test Oscillator */
     // juce::dsp::Oscillator<float> osc;
@@ -0,0 +1,157 @@
+#include <juce_dsp/juce_dsp.h>
+
+namespace
+{
+    // Portable fallback, built with the project's own flags (NEON on ARM)
+    struct GenericOps
+    {
+        using Vec = juce::dsp::SIMDRegister<float>;
+        using Sample = float;
+        static constexpr int numLanes = (int) Vec::SIMDNumElements;
+        static constexpr bool hasVectorLog = false;
+
+        // Callers keep every row aligned to the widest variant's vectors
+        static Vec load(const float* p)    { return Vec::fromRawArray(p); }
+        static void store(float* p, Vec v) { v.copyToRawArray(p); }
+        static Vec set1(float v)           { return Vec::expand(v); }
+        static Vec add(Vec a, Vec b)       { return a + b; }
+        static Vec sub(Vec a, Vec b)       { return a - b; }
+        static Vec mul(Vec a, Vec b)       { return a * b; }
+
+        // SIMDRegister has no division, so this goes lane by lane
+        static Vec div(Vec a, Vec b)
+        {
+            for (size_t i = 0; i < Vec::size(); ++i)
+                a.set(i, a.get(i) / b.get(i));
+
+            return a;
+        }
+
+        static float scalarToDecibels(float gain, float negativeInfinityDb)
+        {
+            return juce::Decibels::gainToDecibels(gain, negativeInfinityDb);
+        }
+    };
+
+    struct GenericDoubleOps
+    {
+        using Vec = juce::dsp::SIMDRegister<double>;
+        using Sample = double;
+        static constexpr int numLanes = (int) Vec::SIMDNumElements;
+
+        static Vec load(const double* p)    { return Vec::fromRawArray(p); }
+        static void store(double* p, Vec v) { v.copyToRawArray(p); }
+        static Vec set1(double v)           { return Vec::expand(v); }
+        static Vec add(Vec a, Vec b)        { return a + b; }
+        static Vec sub(Vec a, Vec b)        { return a - b; }
+        static Vec mul(Vec a, Vec b)        { return a * b; }
+
+        static Vec div(Vec a, Vec b)
+        {
+            for (size_t i = 0; i < Vec::size(); ++i)
+                a.set(i, a.get(i) / b.get(i));
+
+            return a;
+        }
+    };
+}
+
+#include "SIMDKernelsImpl.h"
+
+namespace SIMDKernels
+{
+   #if EQ_X86_KERNEL_VARIANTS
+    const KernelSet& getSSE2KernelSet();
+    const KernelSet& getAVX2KernelSet();
+    const KernelSet& getAVX512KernelSet();
+   #endif
+
+    static const KernelSet& getGenericKernelSet()
+    {
+        static constexpr auto kernels = makeKernelSet<GenericOps, GenericDoubleOps>(InstructionSet::generic, "Generic");
+        return kernels;
+    }
+
+    bool isSupported(InstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+            case InstructionSet::generic:
+                return true;
+           #if EQ_X86_KERNEL_VARIANTS
+            case InstructionSet::sse2:
+                return juce::SystemStats::hasSSE2();
+            case InstructionSet::avx2:
+                return juce::SystemStats::hasAVX2();
+            case InstructionSet::avx512:
+                return juce::SystemStats::hasAVX512F();
+           #endif
+            default:
+                return false;
+        }
+    }
+
+    const KernelSet* getKernelSet(InstructionSet instructionSet)
+    {
+        if (! isSupported(instructionSet))
+            return nullptr;
+
+        switch (instructionSet)
+        {
+           #if EQ_X86_KERNEL_VARIANTS
+            case InstructionSet::sse2:   return &getSSE2KernelSet();
+            case InstructionSet::avx2:   return &getAVX2KernelSet();
+            case InstructionSet::avx512: return &getAVX512KernelSet();
+           #endif
+            default:                     return &getGenericKernelSet();
+        }
+    }
+
+    // Supported variants, narrowest first. CPUID is only queried the first time.
+    static const juce::Array<const KernelSet*>& getSupportedKernelSets()
+    {
+        static const auto supported = []
+        {
+            juce::Array<const KernelSet*> sets;
+
+            for (auto instructionSet : { InstructionSet::generic, InstructionSet::sse2,
+                                         InstructionSet::avx2, InstructionSet::avx512 })
+            {
+                if (auto* kernels = getKernelSet(instructionSet))
+                    sets.add(kernels);
+            }
+
+            return sets;
+        }();
+
+        return supported;
+    }
+
+    const KernelSet& getKernelSetForChannels(int numChannels, bool doublePrecision)
+    {
+        const auto& supported = getSupportedKernelSets();
+
+        auto getNumLanes = [doublePrecision](const KernelSet* kernels)
+        {
+            return doublePrecision ? kernels->doublePrecision.numLanes : kernels->singlePrecision.numLanes;
+        };
+
+        const KernelSet* best = supported.getFirst();
+        for (auto* kernels : supported)
+        {
+            // Later entries are never narrower; at equal width the explicit
+            // SSE2 variant takes over from the generic one.
+            if (getNumLanes(best) >= numChannels && getNumLanes(kernels) > getNumLanes(best))
+                break;
+
+            best = kernels;
+        }
+
+        return *best;
+    }
+
+    const KernelSet& getWidestKernelSet()
+    {
+        return *getSupportedKernelSets().getLast();
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+/*  Hot loops compiled once per instruction set and picked at runtime.
+
+    This header is shared with translation units built with wider target flags
+    (AVX2, AVX-512), so it must stay free of JUCE and of anything that would
+    emit inline code.
+*/
+namespace SIMDKernels
+{
+    enum class InstructionSet
+    {
+        generic,   // juce::dsp::SIMDRegister, whatever the build targets
+        sse2,
+        avx2,
+        avx512
+    };
+
+    //==================================================================
+    // Cascade layout: each section is SectionStride rows of numLanes samples,
+    // one lane per channel.
+    enum SectionRow
+    {
+        B0, B1, B2, A1, A2, S1, S2,
+        SectionStride
+    };
+
+    // A kernel runs up to this many consecutive sections in one pass over the
+    // frames, with their coefficients and state held in registers. Longer
+    // cascades take several passes.
+    constexpr int MaxSectionsPerPass = 9;
+
+    // Layout used while smoothing: the same sections in topology preserving
+    // state variable form, y = m0 x + m1 band + m2 low. For the first
+    // numRampSamples samples every parameter moves by its Delta row per sample.
+    enum SVFRow
+    {
+        G, K, M0, M1, M2,
+        DeltaG, DeltaK, DeltaM0, DeltaM1, DeltaM2,
+        IC1, IC2,
+        SVFStride
+    };
+
+    constexpr int NumSVFParameters = M2 + 1;
+
+    // Polyphase half-band filters for oversampling: two parallel chains of
+    // first order allpass sections, the even numbered coefficients in one and
+    // the odd ones in the other. Their state is two rows of numLanes samples
+    // per coefficient, the last input and output of that section.
+    constexpr int MaxHalfBandCoefficients = 12;
+    constexpr int HalfBandStateStride = 2;
+
+    //==================================================================
+    // Sections, state and frames all hold Sample, float or double
+    template<typename Sample>
+    using CascadeKernel = void (*)(Sample* sections, Sample* frames, size_t numSamples);
+
+    template<typename Sample>
+    using SmoothedCascadeKernel = void (*)(Sample* sections, Sample* frames, size_t numSamples, size_t numRampSamples);
+
+    // Doubles the rate of numInputFrames frames. output may overlap input as long
+    // as input is the second half of output.
+    template<typename Sample>
+    using UpsampleKernel = void (*)(const Sample* coefficients, int numCoefficients, Sample* state,
+                                    const Sample* input, Sample* output, size_t numInputFrames);
+
+    // Halves the rate of 2 * numOutputFrames frames. output may be input.
+    template<typename Sample>
+    using DownsampleKernel = void (*)(const Sample* coefficients, int numCoefficients, Sample* state,
+                                      const Sample* input, Sample* output, size_t numOutputFrames);
+
+    // data[i] = gainToDecibels(data[i] * gainScale, negativeInfinityDb)
+    using DecibelKernel = void (*)(float* data, int numValues, float gainScale, float negativeInfinityDb);
+
+    // Separates the transform of left + i * right, given as fftSize interleaved
+    // complex bins, into the spectra of the two real signals. Writes bins 0 to
+    // numBins - 1 of each to left and right, as for a DecibelKernel.
+    using RealPairDecibelKernel = void (*)(const float* spectrum, int fftSize, float* left, float* right,
+                                           int numBins, float gainScale, float negativeInfinityDb);
+
+    // Everything the cascade runs, for one sample type. A vector holds half
+    // as many doubles as floats.
+    template<typename Sample>
+    struct CascadeKernels
+    {
+        int numLanes;
+
+        // Both indexed by the number of sections in the pass
+        std::array<CascadeKernel<Sample>, MaxSectionsPerPass + 1> cascade;
+        std::array<SmoothedCascadeKernel<Sample>, MaxSectionsPerPass + 1> smoothedCascade;
+        UpsampleKernel<Sample> upsampleHalfBand;
+        DownsampleKernel<Sample> downsampleHalfBand;
+    };
+
+    struct KernelSet
+    {
+        InstructionSet instructionSet;
+        const char* name;
+
+        CascadeKernels<float> singlePrecision;
+        CascadeKernels<double> doublePrecision;
+        DecibelKernel magnitudesToDecibels;
+        RealPairDecibelKernel realPairToDecibels;
+
+        template<typename Sample>
+        const CascadeKernels<Sample>& getCascadeKernels() const
+        {
+            if constexpr (std::is_same_v<Sample, double>)
+                return doublePrecision;
+            else
+                return singlePrecision;
+        }
+    };
+
+    // True if the variant was built into this binary and the CPU can run it
+    bool isSupported(InstructionSet instructionSet);
+
+    // nullptr unless isSupported(instructionSet)
+    const KernelSet* getKernelSet(InstructionSet instructionSet);
+
+    // The narrowest supported variant with a lane for every channel, or the widest one
+    const KernelSet& getKernelSetForChannels(int numChannels, bool doublePrecision = false);
+
+    const KernelSet& getWidestKernelSet();
+}
@@ -0,0 +1,462 @@
+#pragma once
+
+/*  Kernel templates, included by each SIMDKernels_*.cpp after it has defined its
+    Ops struct in an anonymous namespace.
+
+    Those files are built with different target flags, so everything here has
+    internal linkage and nothing calls out to library inlines; a shared inline
+    symbol could otherwise end up running AVX code on a CPU without it.
+
+    Ops provides:
+        Sample, Vec, numLanes, load, store, add, sub, mul, div, set1
+    and for the float Ops, which also runs the decibel conversion:
+        hasVectorLog, and if true: max, IVec, asInt, asFloat, shiftRight23, andInt,
+        orInt, subInt, setInt, toFloat
+        otherwise: scalarToDecibels
+*/
+
+#include "SIMDKernels.h"
+
+#include <utility>
+
+namespace
+{
+    //==================================================================
+    template<typename Ops, int NumSections>
+    void processCascade(typename Ops::Sample* sections, typename Ops::Sample* frames, size_t numSamples)
+    {
+        if constexpr (NumSections > 0)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr int L = Ops::numLanes;
+            constexpr int S = SIMDKernels::SectionStride;
+
+            // Coefficients and state stay in registers for the whole block
+            Vec b0[NumSections], b1[NumSections], b2[NumSections], a1[NumSections], a2[NumSections];
+            Vec s1[NumSections], s2[NumSections];
+
+            for (int s = 0; s < NumSections; ++s)
+            {
+                const auto* section = sections + s * S * L;
+                b0[s] = Ops::load(section + SIMDKernels::B0 * L);
+                b1[s] = Ops::load(section + SIMDKernels::B1 * L);
+                b2[s] = Ops::load(section + SIMDKernels::B2 * L);
+                a1[s] = Ops::load(section + SIMDKernels::A1 * L);
+                a2[s] = Ops::load(section + SIMDKernels::A2 * L);
+                s1[s] = Ops::load(section + SIMDKernels::S1 * L);
+                s2[s] = Ops::load(section + SIMDKernels::S2 * L);
+            }
+
+            // Same transposed direct form II, in the same order, as juce::dsp::IIR::Filter,
+            // so each lane matches the scalar filter sample for sample.
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto x = Ops::load(frames + i * L);
+
+                for (int s = 0; s < NumSections; ++s)
+                {
+                    auto output = Ops::add(Ops::mul(x, b0[s]), s1[s]);
+                    s1[s] = Ops::add(Ops::sub(Ops::mul(x, b1[s]), Ops::mul(output, a1[s])), s2[s]);
+                    s2[s] = Ops::sub(Ops::mul(x, b2[s]), Ops::mul(output, a2[s]));
+                    x = output;
+                }
+
+                Ops::store(frames + i * L, x);
+            }
+
+            for (int s = 0; s < NumSections; ++s)
+            {
+                auto* section = sections + s * S * L;
+                Ops::store(section + SIMDKernels::S1 * L, s1[s]);
+                Ops::store(section + SIMDKernels::S2 * L, s2[s]);
+            }
+        }
+        else
+        {
+            (void) sections;
+            (void) frames;
+            (void) numSamples;
+        }
+    }
+
+    template<typename Ops, size_t... Indices>
+    constexpr std::array<SIMDKernels::CascadeKernel<typename Ops::Sample>, SIMDKernels::MaxSectionsPerPass + 1>
+        makeCascadeTable(std::index_sequence<Indices...>)
+    {
+        return { { &processCascade<Ops, (int) Indices>... } };
+    }
+
+    //==================================================================
+    template<typename Ops, int NumSections>
+    void processSmoothedCascade(typename Ops::Sample* sections, typename Ops::Sample* frames, size_t numSamples, size_t numRampSamples)
+    {
+        if constexpr (NumSections > 0)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr int L = Ops::numLanes;
+            constexpr int S = SIMDKernels::SVFStride;
+
+            Vec p[SIMDKernels::NumSVFParameters][NumSections];
+            Vec delta[SIMDKernels::NumSVFParameters][NumSections];
+            Vec ic1[NumSections], ic2[NumSections];
+
+            for (int s = 0; s < NumSections; ++s)
+            {
+                const auto* section = sections + s * S * L;
+
+                for (int r = 0; r < SIMDKernels::NumSVFParameters; ++r)
+                {
+                    p[r][s] = Ops::load(section + (SIMDKernels::G + r) * L);
+                    delta[r][s] = Ops::load(section + (SIMDKernels::DeltaG + r) * L);
+                }
+
+                ic1[s] = Ops::load(section + SIMDKernels::IC1 * L);
+                ic2[s] = Ops::load(section + SIMDKernels::IC2 * L);
+            }
+
+            const auto one = Ops::set1(1.f);
+            const auto two = Ops::set1(2.f);
+
+            // Trapezoidal SVF after Zavalishin/Simper, which stays stable however fast g and k move
+            auto tick = [&](Vec x, int s, Vec a1, Vec a2, Vec a3)
+            {
+                auto v3 = Ops::sub(x, ic2[s]);
+                auto v1 = Ops::add(Ops::mul(a1, ic1[s]), Ops::mul(a2, v3));
+                auto v2 = Ops::add(ic2[s], Ops::add(Ops::mul(a2, ic1[s]), Ops::mul(a3, v3)));
+                ic1[s] = Ops::sub(Ops::mul(two, v1), ic1[s]);
+                ic2[s] = Ops::sub(Ops::mul(two, v2), ic2[s]);
+
+                return Ops::add(Ops::add(Ops::mul(p[SIMDKernels::M0][s], x),
+                                         Ops::mul(p[SIMDKernels::M1][s], v1)),
+                                Ops::mul(p[SIMDKernels::M2][s], v2));
+            };
+
+            auto getGains = [&](int s, Vec& a1, Vec& a2, Vec& a3)
+            {
+                const auto& g = p[SIMDKernels::G][s];
+                a1 = Ops::div(one, Ops::add(one, Ops::mul(g, Ops::add(g, p[SIMDKernels::K][s]))));
+                a2 = Ops::mul(g, a1);
+                a3 = Ops::mul(g, a2);
+            };
+
+            size_t i = 0;
+            const auto rampEnd = numRampSamples < numSamples ? numRampSamples : numSamples;
+
+            // While ramping: one reciprocal and a few multiplies and adds per section
+            for (; i < rampEnd; ++i)
+            {
+                auto x = Ops::load(frames + i * L);
+
+                for (int s = 0; s < NumSections; ++s)
+                {
+                    Vec a1, a2, a3;
+                    getGains(s, a1, a2, a3);
+                    x = tick(x, s, a1, a2, a3);
+
+                    for (int r = 0; r < SIMDKernels::NumSVFParameters; ++r)
+                        p[r][s] = Ops::add(p[r][s], delta[r][s]);
+                }
+
+                Ops::store(frames + i * L, x);
+            }
+
+            if (i < numSamples)
+            {
+                Vec a1[NumSections], a2[NumSections], a3[NumSections];
+                for (int s = 0; s < NumSections; ++s)
+                    getGains(s, a1[s], a2[s], a3[s]);
+
+                for (; i < numSamples; ++i)
+                {
+                    auto x = Ops::load(frames + i * L);
+
+                    for (int s = 0; s < NumSections; ++s)
+                        x = tick(x, s, a1[s], a2[s], a3[s]);
+
+                    Ops::store(frames + i * L, x);
+                }
+            }
+
+            for (int s = 0; s < NumSections; ++s)
+            {
+                auto* section = sections + s * S * L;
+
+                for (int r = 0; r < SIMDKernels::NumSVFParameters; ++r)
+                    Ops::store(section + (SIMDKernels::G + r) * L, p[r][s]);
+
+                Ops::store(section + SIMDKernels::IC1 * L, ic1[s]);
+                Ops::store(section + SIMDKernels::IC2 * L, ic2[s]);
+            }
+        }
+        else
+        {
+            (void) sections;
+            (void) frames;
+            (void) numSamples;
+            (void) numRampSamples;
+        }
+    }
+
+    template<typename Ops, size_t... Indices>
+    constexpr std::array<SIMDKernels::SmoothedCascadeKernel<typename Ops::Sample>, SIMDKernels::MaxSectionsPerPass + 1>
+        makeSmoothedCascadeTable(std::index_sequence<Indices...>)
+    {
+        return { { &processSmoothedCascade<Ops, (int) Indices>... } };
+    }
+
+    //==================================================================
+    template<typename Ops>
+    struct AllpassChains
+    {
+        using Sample = typename Ops::Sample;
+        using Vec = typename Ops::Vec;
+        static constexpr int L = Ops::numLanes;
+
+        Vec coefficient[SIMDKernels::MaxHalfBandCoefficients];
+        Vec x1[SIMDKernels::MaxHalfBandCoefficients], y1[SIMDKernels::MaxHalfBandCoefficients];
+        int numCoefficients;
+
+        AllpassChains(const Sample* coefficients, int num, const Sample* state) : numCoefficients(num)
+        {
+            for (int i = 0; i < numCoefficients; ++i)
+            {
+                coefficient[i] = Ops::set1(coefficients[i]);
+                x1[i] = Ops::load(state + (i * SIMDKernels::HalfBandStateStride) * L);
+                y1[i] = Ops::load(state + (i * SIMDKernels::HalfBandStateStride + 1) * L);
+            }
+        }
+
+        void save(Sample* state) const
+        {
+            for (int i = 0; i < numCoefficients; ++i)
+            {
+                Ops::store(state + (i * SIMDKernels::HalfBandStateStride) * L, x1[i]);
+                Ops::store(state + (i * SIMDKernels::HalfBandStateStride + 1) * L, y1[i]);
+            }
+        }
+
+        // y = x[n - 1] + a (x - y[n - 1]) through every section of one chain
+        Vec process(Vec x, int firstSection)
+        {
+            for (int i = firstSection; i < numCoefficients; i += 2)
+            {
+                auto y = Ops::add(x1[i], Ops::mul(coefficient[i], Ops::sub(x, y1[i])));
+                x1[i] = x;
+                y1[i] = y;
+                x = y;
+            }
+
+            return x;
+        }
+    };
+
+    template<typename Ops>
+    void upsampleHalfBand(const typename Ops::Sample* coefficients, int numCoefficients, typename Ops::Sample* state,
+                          const typename Ops::Sample* input, typename Ops::Sample* output, size_t numInputFrames)
+    {
+        constexpr int L = Ops::numLanes;
+        AllpassChains<Ops> chains(coefficients, numCoefficients, state);
+
+        // Each input frame is loaded before the two it becomes are stored, and
+        // those never land on a frame still to be read
+        for (size_t i = 0; i < numInputFrames; ++i)
+        {
+            const auto x = Ops::load(input + i * L);
+            const auto even = chains.process(x, 0);
+            const auto odd = chains.process(x, 1);
+
+            Ops::store(output + (2 * i) * L, even);
+            Ops::store(output + (2 * i + 1) * L, odd);
+        }
+
+        chains.save(state);
+    }
+
+    template<typename Ops>
+    void downsampleHalfBand(const typename Ops::Sample* coefficients, int numCoefficients, typename Ops::Sample* state,
+                            const typename Ops::Sample* input, typename Ops::Sample* output, size_t numOutputFrames)
+    {
+        constexpr int L = Ops::numLanes;
+        AllpassChains<Ops> chains(coefficients, numCoefficients, state);
+        const auto half = Ops::set1(0.5f);
+
+        // The filtered signal taken at every odd sample, so no extra delay is needed
+        for (size_t i = 0; i < numOutputFrames; ++i)
+        {
+            const auto even = Ops::load(input + (2 * i) * L);
+            const auto odd = Ops::load(input + (2 * i + 1) * L);
+
+            Ops::store(output + i * L, Ops::mul(half, Ops::add(chains.process(odd, 0), chains.process(even, 1))));
+        }
+
+        chains.save(state);
+    }
+
+    //==================================================================
+    // 20 * log10(x) for x > 0, good to around 1e-5 dB
+    template<typename Ops>
+    typename Ops::Vec gainToDecibels(typename Ops::Vec x)
+    {
+        // x = 2^e * m with m in [1, 2)
+        auto bits = Ops::asInt(x);
+        auto exponent = Ops::toFloat(Ops::subInt(Ops::shiftRight23(bits), Ops::setInt(127)));
+        auto mantissa = Ops::asFloat(Ops::orInt(Ops::andInt(bits, Ops::setInt(0x007fffff)),
+                                                Ops::setInt(0x3f800000)));
+
+        // ln(m) = 2 atanh(t) with t = (m - 1) / (m + 1) in [0, 1/3)
+        auto one = Ops::set1(1.f);
+        auto t = Ops::div(Ops::sub(mantissa, one), Ops::add(mantissa, one));
+        auto t2 = Ops::mul(t, t);
+
+        auto series = Ops::add(Ops::set1(1.f / 7.f), Ops::mul(t2, Ops::set1(1.f / 9.f)));
+        series = Ops::add(Ops::set1(1.f / 5.f), Ops::mul(t2, series));
+        series = Ops::add(Ops::set1(1.f / 3.f), Ops::mul(t2, series));
+        series = Ops::add(one, Ops::mul(t2, series));
+
+        auto lnMantissa = Ops::mul(Ops::mul(Ops::set1(2.f), t), series);
+        auto ln = Ops::add(Ops::mul(exponent, Ops::set1(0.6931471805599453f)), lnMantissa);
+
+        // 20 / ln(10)
+        return Ops::mul(ln, Ops::set1(8.685889638065035f));
+    }
+
+    template<typename Ops>
+    void magnitudesToDecibels(float* data, int numValues, float gainScale, float negativeInfinityDb)
+    {
+        if constexpr (Ops::hasVectorLog)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr int L = Ops::numLanes;
+
+            // Clamping to the smallest normal float keeps the log away from zero
+            // and denormals; anything that quiet ends up at negativeInfinityDb.
+            const auto scale = Ops::set1(gainScale);
+            const auto floorDb = Ops::set1(negativeInfinityDb);
+            const auto floorGain = Ops::set1(1.17549435e-38f);
+
+            auto convert = [&](Vec v)
+            {
+                return Ops::max(gainToDecibels<Ops>(Ops::max(Ops::mul(v, scale), floorGain)), floorDb);
+            };
+
+            int i = 0;
+            for (; i + L <= numValues; i += L)
+                Ops::store(data + i, convert(Ops::load(data + i)));
+
+            if (i < numValues)
+            {
+                // Run the remainder through a padded vector
+                float tail[L] = {};
+                for (int j = 0; i + j < numValues; ++j)
+                    tail[j] = data[i + j];
+
+                Ops::store(tail, convert(Ops::load(tail)));
+
+                for (int j = 0; i + j < numValues; ++j)
+                    data[i + j] = tail[j];
+            }
+        }
+        else
+        {
+            for (int i = 0; i < numValues; ++i)
+                data[i] = Ops::scalarToDecibels(data[i] * gainScale, negativeInfinityDb);
+        }
+    }
+
+    // With X = FFT(left + i * right), a and b the real and imaginary parts of
+    // X[k], and c and d those of X[N - k]:
+    //     LEFT[k] = (X[k] + conj(X[N - k])) / 2,  |LEFT[k]|^2 = ((a + c)^2 + (b - d)^2) / 4
+    //     RIGHT[k] = (X[k] - conj(X[N - k])) / 2i, |RIGHT[k]|^2 = ((a - c)^2 + (b + d)^2) / 4
+    // The decibels come straight from the squared magnitudes, halved, so no square root is needed.
+    template<typename Ops>
+    void realPairToDecibels(const float* spectrum, int fftSize, float* left, float* right,
+                            int numBins, float gainScale, float negativeInfinityDb)
+    {
+        const auto mirror = [fftSize](int bin) { return (fftSize - bin) & (fftSize - 1); };
+        const auto powerScale = 0.25f * gainScale * gainScale;
+
+        if constexpr (Ops::hasVectorLog)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr int L = Ops::numLanes;
+
+            const auto scale = Ops::set1(powerScale);
+            const auto half = Ops::set1(0.5f);
+            const auto floorDb = Ops::set1(negativeInfinityDb);
+            const auto floorPower = Ops::set1(1.17549435e-38f);
+
+            auto convert = [&](Vec power)
+            {
+                return Ops::max(Ops::mul(half, gainToDecibels<Ops>(Ops::max(Ops::mul(power, scale), floorPower))), floorDb);
+            };
+
+            for (int i = 0; i < numBins; i += L)
+            {
+                // Bins and their mirrors are picked out lane by lane, zero past the end;
+                // everything from there on is vectorised
+                float a[L] = {}, b[L] = {}, c[L] = {}, d[L] = {};
+                const auto numInVector = numBins - i < L ? numBins - i : L;
+
+                for (int j = 0; j < numInVector; ++j)
+                {
+                    const auto bin = i + j;
+                    a[j] = spectrum[2 * bin];
+                    b[j] = spectrum[2 * bin + 1];
+                    c[j] = spectrum[2 * mirror(bin)];
+                    d[j] = spectrum[2 * mirror(bin) + 1];
+                }
+
+                const auto va = Ops::load(a), vb = Ops::load(b), vc = Ops::load(c), vd = Ops::load(d);
+                const auto leftReal = Ops::add(va, vc), leftImag = Ops::sub(vb, vd);
+                const auto rightReal = Ops::sub(va, vc), rightImag = Ops::add(vb, vd);
+
+                float leftDb[L], rightDb[L];
+                Ops::store(leftDb, convert(Ops::add(Ops::mul(leftReal, leftReal), Ops::mul(leftImag, leftImag))));
+                Ops::store(rightDb, convert(Ops::add(Ops::mul(rightReal, rightReal), Ops::mul(rightImag, rightImag))));
+
+                for (int j = 0; j < numInVector; ++j)
+                {
+                    left[i + j] = leftDb[j];
+                    right[i + j] = rightDb[j];
+                }
+            }
+        }
+        else
+        {
+            // Twice the floor in power decibels is the floor once halved
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const auto a = spectrum[2 * bin], b = spectrum[2 * bin + 1];
+                const auto c = spectrum[2 * mirror(bin)], d = spectrum[2 * mirror(bin) + 1];
+
+                const auto leftPower = ((a + c) * (a + c) + (b - d) * (b - d)) * powerScale;
+                const auto rightPower = ((a - c) * (a - c) + (b + d) * (b + d)) * powerScale;
+
+                left[bin] = 0.5f * Ops::scalarToDecibels(leftPower, 2.f * negativeInfinityDb);
+                right[bin] = 0.5f * Ops::scalarToDecibels(rightPower, 2.f * negativeInfinityDb);
+            }
+        }
+    }
+
+    //==================================================================
+    template<typename Ops>
+    constexpr SIMDKernels::CascadeKernels<typename Ops::Sample> makeCascadeKernels()
+    {
+        return { Ops::numLanes,
+                 makeCascadeTable<Ops>(std::make_index_sequence<SIMDKernels::MaxSectionsPerPass + 1>()),
+                 makeSmoothedCascadeTable<Ops>(std::make_index_sequence<SIMDKernels::MaxSectionsPerPass + 1>()),
+                 &upsampleHalfBand<Ops>,
+                 &downsampleHalfBand<Ops> };
+    }
+
+    template<typename FloatOps, typename DoubleOps>
+    constexpr SIMDKernels::KernelSet makeKernelSet(SIMDKernels::InstructionSet instructionSet, const char* name)
+    {
+        return { instructionSet,
+                 name,
+                 makeCascadeKernels<FloatOps>(),
+                 makeCascadeKernels<DoubleOps>(),
+                 &magnitudesToDecibels<FloatOps>,
+                 &realPairToDecibels<FloatOps> };
+    }
+}
@@ -0,0 +1,57 @@
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX2Ops
+    {
+        using Vec = __m256;
+        using Sample = float;
+        using IVec = __m256i;
+        static constexpr int numLanes = 8;
+        static constexpr bool hasVectorLog = true;
+
+        static Vec load(const float* p)  { return _mm256_loadu_ps(p); }
+        static void store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+        static Vec set1(float v)          { return _mm256_set1_ps(v); }
+        static Vec add(Vec a, Vec b)      { return _mm256_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)      { return _mm256_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)      { return _mm256_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b)      { return _mm256_div_ps(a, b); }
+        static Vec max(Vec a, Vec b)      { return _mm256_max_ps(a, b); }
+
+        static IVec asInt(Vec v)            { return _mm256_castps_si256(v); }
+        static Vec asFloat(IVec v)          { return _mm256_castsi256_ps(v); }
+        static IVec shiftRight23(IVec v)    { return _mm256_srli_epi32(v, 23); }
+        static IVec andInt(IVec a, IVec b)  { return _mm256_and_si256(a, b); }
+        static IVec orInt(IVec a, IVec b)   { return _mm256_or_si256(a, b); }
+        static IVec subInt(IVec a, IVec b)  { return _mm256_sub_epi32(a, b); }
+        static IVec setInt(int v)           { return _mm256_set1_epi32(v); }
+        static Vec toFloat(IVec v)          { return _mm256_cvtepi32_ps(v); }
+    };
+
+    struct AVX2DoubleOps
+    {
+        using Vec = __m256d;
+        using Sample = double;
+        static constexpr int numLanes = 4;
+
+        static Vec load(const double* p)    { return _mm256_loadu_pd(p); }
+        static void store(double* p, Vec v) { _mm256_storeu_pd(p, v); }
+        static Vec set1(double v)           { return _mm256_set1_pd(v); }
+        static Vec add(Vec a, Vec b)        { return _mm256_add_pd(a, b); }
+        static Vec sub(Vec a, Vec b)        { return _mm256_sub_pd(a, b); }
+        static Vec mul(Vec a, Vec b)        { return _mm256_mul_pd(a, b); }
+        static Vec div(Vec a, Vec b)        { return _mm256_div_pd(a, b); }
+    };
+}
+
+#include "SIMDKernelsImpl.h"
+
+namespace SIMDKernels
+{
+    const KernelSet& getAVX2KernelSet()
+    {
+        static constexpr auto kernels = makeKernelSet<AVX2Ops, AVX2DoubleOps>(InstructionSet::avx2, "AVX2");
+        return kernels;
+    }
+}
@@ -0,0 +1,57 @@
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX512Ops
+    {
+        using Vec = __m512;
+        using Sample = float;
+        using IVec = __m512i;
+        static constexpr int numLanes = 16;
+        static constexpr bool hasVectorLog = true;
+
+        static Vec load(const float* p)  { return _mm512_loadu_ps(p); }
+        static void store(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+        static Vec set1(float v)          { return _mm512_set1_ps(v); }
+        static Vec add(Vec a, Vec b)      { return _mm512_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)      { return _mm512_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)      { return _mm512_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b)      { return _mm512_div_ps(a, b); }
+        static Vec max(Vec a, Vec b)      { return _mm512_max_ps(a, b); }
+
+        static IVec asInt(Vec v)            { return _mm512_castps_si512(v); }
+        static Vec asFloat(IVec v)          { return _mm512_castsi512_ps(v); }
+        static IVec shiftRight23(IVec v)    { return _mm512_srli_epi32(v, 23); }
+        static IVec andInt(IVec a, IVec b)  { return _mm512_and_si512(a, b); }
+        static IVec orInt(IVec a, IVec b)   { return _mm512_or_si512(a, b); }
+        static IVec subInt(IVec a, IVec b)  { return _mm512_sub_epi32(a, b); }
+        static IVec setInt(int v)           { return _mm512_set1_epi32(v); }
+        static Vec toFloat(IVec v)          { return _mm512_cvtepi32_ps(v); }
+    };
+
+    struct AVX512DoubleOps
+    {
+        using Vec = __m512d;
+        using Sample = double;
+        static constexpr int numLanes = 8;
+
+        static Vec load(const double* p)    { return _mm512_loadu_pd(p); }
+        static void store(double* p, Vec v) { _mm512_storeu_pd(p, v); }
+        static Vec set1(double v)           { return _mm512_set1_pd(v); }
+        static Vec add(Vec a, Vec b)        { return _mm512_add_pd(a, b); }
+        static Vec sub(Vec a, Vec b)        { return _mm512_sub_pd(a, b); }
+        static Vec mul(Vec a, Vec b)        { return _mm512_mul_pd(a, b); }
+        static Vec div(Vec a, Vec b)        { return _mm512_div_pd(a, b); }
+    };
+}
+
+#include "SIMDKernelsImpl.h"
+
+namespace SIMDKernels
+{
+    const KernelSet& getAVX512KernelSet()
+    {
+        static constexpr auto kernels = makeKernelSet<AVX512Ops, AVX512DoubleOps>(InstructionSet::avx512, "AVX-512");
+        return kernels;
+    }
+}
@@ -0,0 +1,57 @@
+#include <emmintrin.h>
+
+namespace
+{
+    struct SSE2Ops
+    {
+        using Vec = __m128;
+        using Sample = float;
+        using IVec = __m128i;
+        static constexpr int numLanes = 4;
+        static constexpr bool hasVectorLog = true;
+
+        static Vec load(const float* p)  { return _mm_loadu_ps(p); }
+        static void store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+        static Vec set1(float v)          { return _mm_set1_ps(v); }
+        static Vec add(Vec a, Vec b)      { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b)      { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b)      { return _mm_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b)      { return _mm_div_ps(a, b); }
+        static Vec max(Vec a, Vec b)      { return _mm_max_ps(a, b); }
+
+        static IVec asInt(Vec v)            { return _mm_castps_si128(v); }
+        static Vec asFloat(IVec v)          { return _mm_castsi128_ps(v); }
+        static IVec shiftRight23(IVec v)    { return _mm_srli_epi32(v, 23); }
+        static IVec andInt(IVec a, IVec b)  { return _mm_and_si128(a, b); }
+        static IVec orInt(IVec a, IVec b)   { return _mm_or_si128(a, b); }
+        static IVec subInt(IVec a, IVec b)  { return _mm_sub_epi32(a, b); }
+        static IVec setInt(int v)           { return _mm_set1_epi32(v); }
+        static Vec toFloat(IVec v)          { return _mm_cvtepi32_ps(v); }
+    };
+
+    struct SSE2DoubleOps
+    {
+        using Vec = __m128d;
+        using Sample = double;
+        static constexpr int numLanes = 2;
+
+        static Vec load(const double* p)    { return _mm_loadu_pd(p); }
+        static void store(double* p, Vec v) { _mm_storeu_pd(p, v); }
+        static Vec set1(double v)           { return _mm_set1_pd(v); }
+        static Vec add(Vec a, Vec b)        { return _mm_add_pd(a, b); }
+        static Vec sub(Vec a, Vec b)        { return _mm_sub_pd(a, b); }
+        static Vec mul(Vec a, Vec b)        { return _mm_mul_pd(a, b); }
+        static Vec div(Vec a, Vec b)        { return _mm_div_pd(a, b); }
+    };
+}
+
+#include "SIMDKernelsImpl.h"
+
+namespace SIMDKernels
+{
+    const KernelSet& getSSE2KernelSet()
+    {
+        static constexpr auto kernels = makeKernelSet<SSE2Ops, SSE2DoubleOps>(InstructionSet::sse2, "SSE2");
+        return kernels;
+    }
+}
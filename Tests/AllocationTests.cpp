@@ -0,0 +1,179 @@
+#include "../PluginProcessor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//==============================================================================
+// Every allocation in the process goes through these. Normally only the ones
+// made on a thread that has switched counting on are counted, so the designer
+// and analyser threads can keep allocating while the audio thread is watched.
+// Counting on every thread catches the channel workers too.
+namespace
+{
+    thread_local bool countingAllocations = false;
+    std::atomic<bool> countingOnEveryThread { false };
+    std::atomic<int> numAllocations { 0 };
+
+    bool isCounting()
+    {
+        return countingAllocations || countingOnEveryThread.load(std::memory_order_relaxed);
+    }
+
+    void* allocate(std::size_t size)
+    {
+        if (isCounting())
+            ++numAllocations;
+
+        if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocate(void* ptr) noexcept
+    {
+        if (ptr != nullptr && isCounting())
+            ++numAllocations;
+
+        std::free(ptr);
+    }
+
+    // Over-allocates and keeps malloc's pointer just before the aligned block
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        const auto align = juce::jmax((std::size_t) alignment, sizeof(void*));
+        auto* raw = static_cast<char*>(allocate(size + align + sizeof(void*)));
+
+        auto address = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+        address = (address + align - 1) & ~(std::uintptr_t) (align - 1);
+
+        reinterpret_cast<void**>(address)[-1] = raw;
+        return reinterpret_cast<void*>(address);
+    }
+
+    void deallocateAligned(void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            deallocate(static_cast<void**>(ptr)[-1]);
+    }
+
+    template<typename Function>
+    int countAllocations(bool onEveryThread, Function&& function)
+    {
+        numAllocations = 0;
+        countingAllocations = true;
+        countingOnEveryThread = onEveryThread;
+        function();
+        countingOnEveryThread = false;
+        countingAllocations = false;
+        return numAllocations.load();
+    }
+}
+
+void* operator new(std::size_t size)                                    { return allocate(size); }
+void* operator new[](std::size_t size)                                  { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment)        { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment)      { return allocateAligned(size, alignment); }
+void operator delete(void* ptr) noexcept                                { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept                              { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                   { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept                 { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept              { deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept            { deallocateAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept     { deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept   { deallocateAligned(ptr); }
+
+//==============================================================================
+// Drives processBlock() under each processing mode, automating the bands between
+// blocks the way a host would, and fails if a single block allocates or frees.
+class AudioThreadAllocationTests : public juce::UnitTest
+{
+public:
+    AudioThreadAllocationTests() : juce::UnitTest("Audio thread allocations", "Allocation") {}
+
+    void runTest() override
+    {
+        runScenario<float>("Default settings", {});
+        runScenario<float>("Ramped automation", { { "Automation Smoothing", 1.f } });
+        runScenario<float>("Crossfaded automation", { { "Automation Smoothing", 2.f } });
+        runScenario<float>("4x oversampling", { { "Oversampling", 2.f } });
+        runScenario<float>("Linear phase", { { "Linear Phase", 1.f } });
+        runScenario<float>("Multithreaded channels", { { "Multithreaded Channels", 1.f } }, 32, true);
+        runScenario<float>("Mid/Side", { { "Stereo Mode", 1.f }, { "Peak Bypassed 2", 0.f } });
+        runScenario<float>("All peak bands", { { "Peak 2 Bypassed", 0.f }, { "Peak 9 Bypassed", 0.f },
+                                               { "LowCut Slope", 3.f }, { "HighCut Freq", 8000.f } });
+        runScenario<double>("Double precision", { { "Automation Smoothing", 1.f }, { "Oversampling", 1.f } });
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+    static constexpr int numBlocks = 200;
+
+    // How long the designer gets after each sweep step. When counting on every
+    // thread its designs must be finished before the next block, or they'd count.
+    static constexpr int designSettleMs = 5;
+    static constexpr int everyThreadDesignSettleMs = 50;
+
+    static void setParameter(AudioPluginAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // A wide bus gives the channel workers more than one lane group to take;
+    // their allocations only show up when counting on every thread.
+    template<typename SampleType>
+    void runScenario(const juce::String& name,
+                     std::initializer_list<std::pair<const char*, float>> settings,
+                     int numChannels = 2, bool countOnEveryThread = false)
+    {
+        beginTest(name);
+
+        AudioPluginAudioProcessor processor;
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        for (const auto& [parameterID, value] : settings)
+            setParameter(processor, parameterID, value);
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(0x5eed);
+
+        int allocations = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            // Sweeps the peak and low cut every few blocks, so the designer publishes
+            // while the audio thread is picking designs up and gliding between them
+            if (block % 8 == 0)
+            {
+                const auto position = (float) (block % 64) / 64.f;
+                setParameter(processor, "Peak Freq", 200.f + 4000.f * position);
+                setParameter(processor, "Peak Gain", block % 16 == 0 ? 9.f : -9.f);
+                setParameter(processor, "LowCut Freq", 20.f + 300.f * position);
+                juce::Thread::sleep(countOnEveryThread ? everyThreadDesignSettleMs : designSettleMs);
+            }
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample(channel, i, (SampleType) (random.nextFloat() * 2.f - 1.f));
+
+            allocations += countAllocations(countOnEveryThread, [&] { processor.processBlock(buffer, midi); });
+        }
+
+        expectEquals(allocations, 0, "processBlock() allocated or freed memory");
+
+        processor.releaseResources();
+    }
+};
+
+static AudioThreadAllocationTests audioThreadAllocationTests;
@@ -0,0 +1,182 @@
+#include "../PluginProcessor.h"
+
+#include <cstdio>
+
+//==============================================================================
+// Times the cascade in float and in double, and the whole processor on
+// automated bounce-sized blocks, in nanoseconds per sample per channel. Not a
+// test: the numbers depend on the machine, so it only prints them.
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numWarmUpBlocks = 200;
+    constexpr int numTimedBlocks = 4000;
+
+    StereoChainCoefficients makeCoefficients(double rate, float peakGain)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 30.f;
+        settings.lowCutSlope = Slope_48;
+        settings.highCutFreq = 16000.f;
+        settings.highCutSlope = Slope_48;
+        settings.peakFreq = 1000.f;
+        settings.peakGainInDecibels = peakGain;
+        settings.peakQuality = 1.f;
+
+        for (size_t i = 0; i < settings.extraPeaks.size(); ++i)
+            settings.extraPeaks[i] = { 60.f * (float) (i + 2), -2.f, 1.5f, i >= 3 };
+
+        StereoChainCoefficients coefficients;
+
+        for (auto& channelSet : coefficients.channelSets)
+        {
+            designLowCutInDoublePrecision(settings, rate, channelSet);
+            designPeakInDoublePrecision(settings, rate, channelSet);
+            designHighCutInDoublePrecision(settings, rate, channelSet);
+            channelSet.sampleRate = rate;
+        }
+
+        return coefficients;
+    }
+
+    template<typename SampleType>
+    double measureNanosecondsPerSample(int numChannels, BiquadCascadeBase::UpdateMode mode, int oversamplingFactor)
+    {
+        BiquadCascade<SampleType> cascade;
+        cascade.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+        cascade.setUpdateMode(mode, blockSize);
+        cascade.setOversamplingFactor(oversamplingFactor);
+
+        const auto rate = sampleRate * oversamplingFactor;
+        const std::array<StereoChainCoefficients, 2> coefficients { makeCoefficients(rate, 6.f), makeCoefficients(rate, -6.f) };
+        cascade.setCoefficients(coefficients[0], { true, true, true });
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::Random random(7);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample(channel, i, (SampleType) (random.nextFloat() * 2.f - 1.f));
+
+        const auto block = juce::dsp::AudioBlock<SampleType>(buffer);
+
+        // In ramped mode a new peak every few blocks keeps the smoothing kernels busy
+        auto processBlocks = [&](int numBlocks)
+        {
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                if (mode == BiquadCascadeBase::UpdateMode::ramped && i % 4 == 0)
+                    cascade.setCoefficients(coefficients[(size_t) (i / 4) % 2], { false, true, false });
+
+                cascade.process(block);
+            }
+        };
+
+        processBlocks(numWarmUpBlocks);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processBlocks(numTimedBlocks);
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        return elapsed * 1.0e9 / ((double) numTimedBlocks * blockSize * numChannels);
+    }
+
+    //==========================================================================
+    // A bounce: big blocks through the whole processor. With the peak moving
+    // every block, each one is filtered in sub-blocks with designs in between,
+    // so against the settings held this is what sub-blocking costs.
+    constexpr int bounceBlockSize = 4096;
+    constexpr int numBounceBlocks = 500;
+
+    double measureBounceNanosecondsPerSample(int numChannels, bool automated, bool multithreaded)
+    {
+        AudioPluginAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, bounceBlockSize);
+        processor.prepareToPlay(sampleRate, bounceBlockSize);
+
+        auto setParameter = [&processor](const char* parameterID, float value)
+        {
+            auto* parameter = processor.apvts.getParameter(parameterID);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        };
+
+        setParameter("Multithreaded Channels", multithreaded ? 1.f : 0.f);
+        setParameter("Peak Gain", 6.f);
+        setParameter("Peak 2 Bypassed", 0.f);
+        setParameter("LowCut Slope", 3.f);
+
+        // Lets the designer publish before timing starts
+        juce::Thread::sleep(50);
+
+        juce::AudioBuffer<float> buffer(numChannels, bounceBlockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(11);
+        juce::int64 ticks = 0;
+
+        for (int block = 0; block < numBounceBlocks; ++block)
+        {
+            if (automated)
+                setParameter("Peak Freq", block % 2 == 0 ? 500.f : 2000.f);
+
+            // Fresh noise every block, so the processor never sees silence
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < bounceBlockSize; ++i)
+                    buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        processor.releaseResources();
+
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9
+             / ((double) numBounceBlocks * bounceBlockSize * numChannels);
+    }
+}
+
+int main()
+{
+    using UpdateMode = BiquadCascadeBase::UpdateMode;
+
+    // The processor needs a message thread for its parameter listeners
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // The same block is filtered over and over, so it would otherwise decay into denormals
+    juce::ScopedNoDenormals noDenormals;
+
+    std::printf("%-10s %-10s %-5s %12s %12s %8s\n", "channels", "mode", "os", "float ns", "double ns", "ratio");
+
+    for (int numChannels : { 2, 8 })
+    {
+        for (const auto mode : { UpdateMode::immediate, UpdateMode::ramped })
+        {
+            for (int oversamplingFactor : { 1, 4 })
+            {
+                const auto floatTime = measureNanosecondsPerSample<float>(numChannels, mode, oversamplingFactor);
+                const auto doubleTime = measureNanosecondsPerSample<double>(numChannels, mode, oversamplingFactor);
+
+                std::printf("%-10d %-10s %-4dx %12.3f %12.3f %8.2f\n", numChannels,
+                            mode == UpdateMode::immediate ? "immediate" : "ramped",
+                            oversamplingFactor, floatTime, doubleTime, doubleTime / floatTime);
+            }
+        }
+    }
+
+    std::printf("\n%-10s %-10s %-14s %12s %12s %8s\n", "channels", "block", "threads", "held ns", "automated ns", "ratio");
+
+    for (int numChannels : { 2, 32 })
+    {
+        for (bool multithreaded : { false, true })
+        {
+            const auto heldTime = measureBounceNanosecondsPerSample(numChannels, false, multithreaded);
+            const auto automatedTime = measureBounceNanosecondsPerSample(numChannels, true, multithreaded);
+
+            std::printf("%-10d %-10d %-14s %12.3f %12.3f %8.2f\n", numChannels, bounceBlockSize,
+                        multithreaded ? "multithreaded" : "single", heldTime, automatedTime, automatedTime / heldTime);
+        }
+    }
+
+    return 0;
+}
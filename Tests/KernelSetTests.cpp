@@ -0,0 +1,202 @@
+#include "../PluginProcessor.h"
+
+#include <vector>
+
+//==============================================================================
+// Forces each kernel variant the CPU can run and checks it against the generic
+// one: the cascade in every update mode and oversampling factor, in both
+// precisions, and the analyser's decibel kernels.
+class KernelSetTests : public juce::UnitTest
+{
+public:
+    KernelSetTests() : juce::UnitTest("Kernel sets", "Kernels") {}
+
+    void runTest() override
+    {
+        using SIMDKernels::InstructionSet;
+
+        const auto* reference = SIMDKernels::getKernelSet(InstructionSet::generic);
+
+        beginTest("The generic variant is always available");
+        expect(reference != nullptr);
+
+        if (reference == nullptr)
+            return;
+
+        for (const auto instructionSet : { InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512 })
+        {
+            const auto* kernels = SIMDKernels::getKernelSet(instructionSet);
+            expect((kernels != nullptr) == SIMDKernels::isSupported(instructionSet));
+
+            if (kernels == nullptr)
+            {
+                logMessage("Skipping unsupported variant " + juce::String((int) instructionSet));
+                continue;
+            }
+
+            beginTest(juce::String(kernels->name) + " cascade");
+            compareCascades<float>(*reference, *kernels, 1.0e-3);
+            compareCascades<double>(*reference, *kernels, 1.0e-9);
+
+            beginTest(juce::String(kernels->name) + " decibel kernels");
+            compareDecibelKernels(*reference, *kernels);
+        }
+
+        beginTest("getKernelSetForChannels");
+        for (int numChannels : { 1, 2, 4, 8, 12, 16, 32 })
+        {
+            for (bool doublePrecision : { false, true })
+            {
+                const auto& kernels = SIMDKernels::getKernelSetForChannels(numChannels, doublePrecision);
+                const auto numLanes = doublePrecision ? kernels.doublePrecision.numLanes : kernels.singlePrecision.numLanes;
+
+                expect(SIMDKernels::isSupported(kernels.instructionSet));
+                expect(numLanes >= numChannels || &kernels == &SIMDKernels::getWidestKernelSet());
+            }
+        }
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 256;
+    static constexpr int numBlocks = 24;
+
+    static StereoChainCoefficients makeCoefficients(double rate, float peakGain)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.f;
+        settings.lowCutSlope = Slope_36;
+        settings.highCutFreq = 12000.f;
+        settings.highCutSlope = Slope_24;
+        settings.peakFreq = 1000.f;
+        settings.peakGainInDecibels = peakGain;
+        settings.peakQuality = 1.f;
+
+        for (size_t i = 0; i < settings.extraPeaks.size(); ++i)
+            settings.extraPeaks[i] = { 100.f * (float) (i + 2), -3.f, 2.f, i % 3 == 0 };
+
+        StereoChainCoefficients coefficients;
+
+        for (auto& channelSet : coefficients.channelSets)
+        {
+            designLowCutInDoublePrecision(settings, rate, channelSet);
+            designPeakInDoublePrecision(settings, rate, channelSet);
+            designHighCutInDoublePrecision(settings, rate, channelSet);
+            channelSet.sampleRate = rate;
+        }
+
+        return coefficients;
+    }
+
+    // Runs the same noise through a cascade on each variant, switching designs
+    // halfway so the ramp and crossfade kernels get exercised too
+    template<typename SampleType>
+    std::vector<SampleType> runCascade(const SIMDKernels::KernelSet& kernels, int numChannels,
+                                       BiquadCascadeBase::UpdateMode mode, int oversamplingFactor)
+    {
+        const auto spec = juce::dsp::ProcessSpec { sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels };
+
+        BiquadCascade<SampleType> cascade;
+        cascade.prepare(spec, kernels);
+        cascade.setUpdateMode(mode, blockSize * 3);
+        cascade.setOversamplingFactor(oversamplingFactor);
+
+        const std::array<bool, 3> allStages { true, true, true };
+        const auto rate = sampleRate * oversamplingFactor;
+        cascade.setCoefficients(makeCoefficients(rate, 6.f), allStages);
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::Random random(1234);
+        std::vector<SampleType> output;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block == numBlocks / 2)
+                cascade.setCoefficients(makeCoefficients(rate, -9.f), allStages);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample(channel, i, (SampleType) (random.nextFloat() * 2.f - 1.f));
+
+            cascade.process(juce::dsp::AudioBlock<SampleType>(buffer));
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                output.insert(output.end(), buffer.getReadPointer(channel), buffer.getReadPointer(channel) + blockSize);
+        }
+
+        return output;
+    }
+
+    template<typename SampleType>
+    void compareCascades(const SIMDKernels::KernelSet& reference, const SIMDKernels::KernelSet& kernels, double tolerance)
+    {
+        using UpdateMode = BiquadCascadeBase::UpdateMode;
+
+        for (const auto mode : { UpdateMode::immediate, UpdateMode::ramped, UpdateMode::crossfade })
+        {
+            for (int oversamplingFactor : { 1, 2, 4 })
+            {
+                for (int numChannels : { 2, 5, 16 })
+                {
+                    const auto expected = runCascade<SampleType>(reference, numChannels, mode, oversamplingFactor);
+                    const auto actual = runCascade<SampleType>(kernels, numChannels, mode, oversamplingFactor);
+
+                    double maxError = 0;
+                    for (size_t i = 0; i < expected.size(); ++i)
+                        maxError = juce::jmax(maxError, std::abs((double) actual[i] - (double) expected[i]));
+
+                    expectWithinAbsoluteError(maxError, 0.0, tolerance,
+                                              juce::String(kernels.name) + (BiquadCascade<SampleType>::isDoublePrecision ? " double" : " float")
+                                                  + ", mode " + juce::String((int) mode)
+                                                  + ", " + juce::String(oversamplingFactor) + "x, "
+                                                  + juce::String(numChannels) + " channels");
+                }
+            }
+        }
+    }
+
+    void compareDecibelKernels(const SIMDKernels::KernelSet& reference, const SIMDKernels::KernelSet& kernels)
+    {
+        constexpr int fftSize = 2048;
+        constexpr int numBins = fftSize / 2;
+        constexpr float gainScale = 2.f / (float) fftSize;
+        constexpr float negativeInfinity = -48.f;
+
+        juce::Random random(42);
+        std::vector<float> spectrum((size_t) fftSize * 2);
+        for (auto& value : spectrum)
+            value = (random.nextFloat() * 2.f - 1.f) * 100.f;
+
+        // Some exact zeros, to hit the negative infinity clamp
+        std::fill(spectrum.begin() + 64, spectrum.begin() + 80, 0.f);
+
+        auto magnitudes = std::vector<float>(spectrum.begin(), spectrum.begin() + numBins);
+        for (auto& value : magnitudes)
+            value = std::abs(value);
+
+        auto expected = magnitudes, actual = magnitudes;
+        reference.magnitudesToDecibels(expected.data(), numBins, gainScale, negativeInfinity);
+        kernels.magnitudesToDecibels(actual.data(), numBins, gainScale, negativeInfinity);
+        expectWithinAbsoluteError(maxDifference(expected, actual), 0.f, 1.0e-3f, "magnitudesToDecibels");
+
+        std::vector<float> expectedLeft((size_t) numBins), expectedRight((size_t) numBins);
+        std::vector<float> actualLeft((size_t) numBins), actualRight((size_t) numBins);
+        reference.realPairToDecibels(spectrum.data(), fftSize, expectedLeft.data(), expectedRight.data(),
+                                     numBins, gainScale, negativeInfinity);
+        kernels.realPairToDecibels(spectrum.data(), fftSize, actualLeft.data(), actualRight.data(),
+                                   numBins, gainScale, negativeInfinity);
+        expectWithinAbsoluteError(maxDifference(expectedLeft, actualLeft), 0.f, 1.0e-3f, "realPairToDecibels, left");
+        expectWithinAbsoluteError(maxDifference(expectedRight, actualRight), 0.f, 1.0e-3f, "realPairToDecibels, right");
+    }
+
+    static float maxDifference(const std::vector<float>& first, const std::vector<float>& second)
+    {
+        float difference = 0;
+        for (size_t i = 0; i < first.size(); ++i)
+            difference = juce::jmax(difference, std::abs(first[i] - second[i]));
+
+        return difference;
+    }
+};
+
+static KernelSetTests kernelSetTests;